@@ -3,7 +3,8 @@
 
 #include "client-game-state.h"
 
-std::string card_list_string(std::vector<Card> cards)
+template <typename Cards>
+static std::string card_list_string(const Cards &cards)
 {
     std::string result;
     for (size_t i = 0; i < cards.size(); ++i)
@@ -46,15 +47,15 @@ void ClientGameState::new_deal(const DEALMessage &deal_message)
     trick_ended = true;
     deal_type = deal_message.type;
     starting_player = deal_message.first_player;
-    hand = deal_message.cards;
+    hand.assign(deal_message.cards.begin(), deal_message.cards.end());
     taken_tricks = std::vector<std::vector<Card>>();
     waiting_for_move = false;
 
     if (verbose)
         std::cout << "New deal "
-                  << ::to_string<DealType>(deal_type)
+                  << deal_type_digit(deal_type)
                   << ": staring place "
-                  << ::to_string<Position>(starting_player)
+                  << position_letter(starting_player)
                   << ", your cards: "
                   << card_list_string(hand)
                   << ".\n";
@@ -98,7 +99,7 @@ void ClientGameState::end_trick(const TAKENMessage &taken_message)
     waiting_for_move = false;
 
     if (taken_message.taken_by == position)
-        taken_tricks.push_back(taken_message.cards);
+        taken_tricks.emplace_back(taken_message.cards.begin(), taken_message.cards.end());
 
     for (const auto &card : taken_message.cards)
     {
@@ -113,7 +114,7 @@ void ClientGameState::end_trick(const TAKENMessage &taken_message)
         std::cout << "A trick "
                   << trick
                   << " is taken by "
-                  << ::to_string<Position>(taken_message.taken_by)
+                  << position_letter(taken_message.taken_by)
                   << ", cards "
                   << card_list_string(taken_message.cards)
                   << ".\n";
@@ -121,7 +122,7 @@ void ClientGameState::end_trick(const TAKENMessage &taken_message)
     trick = taken_message.trick_number + 1;
 }
 
-void ClientGameState::get_score(SCOREMessage score_message)
+void ClientGameState::get_score(const SCOREMessage &score_message)
 {
     if (deal_ended)
         throw std::invalid_argument("Deal has ended");
@@ -132,18 +133,18 @@ void ClientGameState::get_score(SCOREMessage score_message)
     got_score = true;
     deal_ended = got_score && got_total;
     waiting_for_move = false;
-    points = score_message.scores[position];
+    points = score_message.scores.at(position);
     total_points += points;
 
     if (verbose)
     {
         std::cout << "The scores are:\n";
         for (auto const &pos: order)
-            std::cout << ::to_string<Position>(pos) << " | " << score_message.scores[pos] << "\n";
+            std::cout << position_letter(pos) << " | " << score_message.scores.at(pos) << "\n";
     }
 }
 
-void ClientGameState::get_total(TOTALMessage total_message)
+void ClientGameState::get_total(const TOTALMessage &total_message)
 {
     if (deal_ended)
         throw std::invalid_argument("Deal has ended");
@@ -155,13 +156,13 @@ void ClientGameState::get_total(TOTALMessage total_message)
     deal_ended = got_score && got_total;
 
     waiting_for_move = false;
-    total_points = total_message.totals[position];
+    total_points = total_message.totals.at(position);
 
     if (verbose)
     {
         std::cout << "The total scores are:\n";
         for (auto const &pos: order)
-            std::cout << ::to_string<Position>(pos) << " | " << total_message.totals[pos] << "\n";
+            std::cout << position_letter(pos) << " | " << total_message.totals.at(pos) << "\n";
     }
 }
 
@@ -179,7 +180,7 @@ std::vector<Card> ClientGameState::get_valid_moves()
     std::vector<Card> valid_moves;
     for (const auto &card : hand)
     {
-        if (card.color == trick_cards[0].color)
+        if (card.color() == trick_cards[0].color())
             valid_moves.push_back(card);
     }
 
@@ -213,7 +214,7 @@ Card ClientGameState::get_best_move()
     Card first_trick_card = trick_cards[0];
     Card best_move = valid_moves[0];
     for (const auto &card : valid_moves)
-        if (!card.compare(best_move, first_trick_card.color) && card.compare(first_trick_card, first_trick_card.color))
+        if (!card.compare(best_move, first_trick_card.color()) && card.compare(first_trick_card, first_trick_card.color()))
             best_move = card;
 
     return best_move;
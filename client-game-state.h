@@ -24,7 +24,7 @@ public:
     Position starting_player;
     std::vector<Position> order;
     std::vector<Card> hand;
-    std::vector<Card> trick_cards;
+    CardList trick_cards;
     std::vector<std::vector<Card>> taken_tricks;
 
     /**
@@ -56,13 +56,13 @@ public:
      * @brief Get score message.
      * @param points_message The points message.
      */
-    void get_score(SCOREMessage score_message);
+    void get_score(const SCOREMessage &score_message);
 
     /**
      * @brief Get total score.
      * @param total_message The total message.
      */
-    void get_total(TOTALMessage total_message);
+    void get_total(const TOTALMessage &total_message);
 
     /**
      * @brief Get the valid moves for the current state.
@@ -1,8 +1,10 @@
-#include <regex>
-#include <set>
+#include <algorithm>
+#include <string.h>
 
 #include "common.h"
 
+#define MAX_NUMBER_DIGITS 9
+
 template <typename T>
 std::string to_string(T value)
 {
@@ -20,349 +22,681 @@ T from_string(const std::string &str)
 template <>
 std::string to_string(Color color)
 {
-    return std::string(1, static_cast<char>(color));
+    return std::string(1, color_letter(color));
 }
 
 template <>
 Color from_string(const std::string &str)
 {
-    if (str.size() != 1 || (str[0] != 'H' && str[0] != 'D' && str[0] != 'C' && str[0] != 'S'))
+    std::optional<Color> color = str.size() == 1 ? color_from_letter(str[0]) : std::nullopt;
+    if (!color.has_value())
         throw std::invalid_argument("Invalid color string");
 
-    return static_cast<Color>(str[0]);
+    return color.value();
 }
 
 template <>
 std::string to_string(MessageType type)
 {
-    static std::map<MessageType, std::string> type_to_string = {
-        {MessageType::IAM, "IAM"},
-        {MessageType::BUSY, "BUSY"},
-        {MessageType::DEAL, "DEAL"},
-        {MessageType::TRICK, "TRICK"},
-        {MessageType::WRONG, "WRONG"},
-        {MessageType::TAKEN, "TAKEN"},
-        {MessageType::SCORE, "SCORE"},
-        {MessageType::TOTAL, "TOTAL"}};
-
-    return type_to_string[type];
+    return std::string(message_type_header(type));
 }
 
 template <>
 MessageType from_string(const std::string &str)
 {
-    static std::map<std::string, MessageType> string_to_type = {
-        {"IAM", MessageType::IAM},
-        {"BUSY", MessageType::BUSY},
-        {"DEAL", MessageType::DEAL},
-        {"TRICK", MessageType::TRICK},
-        {"WRONG", MessageType::WRONG},
-        {"TAKEN", MessageType::TAKEN},
-        {"SCORE", MessageType::SCORE},
-        {"TOTAL", MessageType::TOTAL}};
-
-    if (string_to_type.find(str) == string_to_type.end())
+    std::optional<MessageType> type = message_type_from_header(str);
+    if (!type.has_value())
         throw std::invalid_argument("Invalid message type string");
 
-    return string_to_type[str];
+    return type.value();
 }
 
 template <>
 std::string to_string<Position>(Position position)
 {
-    switch (position)
-    {
-    case Position::North:
-        return "N";
-    case Position::East:
-        return "E";
-    case Position::South:
-        return "S";
-    case Position::West:
-        return "W";
-    default:
+    if (!position_from_letter(position_letter(position)).has_value())
         throw std::invalid_argument("Invalid position");
-    }
+
+    return std::string(1, position_letter(position));
 }
 
 template <>
 Position from_string<Position>(const std::string &str)
 {
-    if (str == "N")
-        return Position::North;
-    else if (str == "E")
-        return Position::East;
-    else if (str == "S")
-        return Position::South;
-    else if (str == "W")
-        return Position::West;
-    else
+    std::optional<Position> position = str.size() == 1 ? position_from_letter(str[0]) : std::nullopt;
+    if (!position.has_value())
         throw std::invalid_argument("Invalid position string");
+
+    return position.value();
 }
 
 template <>
 std::string to_string<DealType>(DealType deal_type)
 {
-    int value = static_cast<int>(deal_type);
-    return std::to_string(value);
+    return std::string(1, deal_type_digit(deal_type));
 }
 
 template <>
 DealType from_string<DealType>(const std::string &str)
 {
-    int value;
-    try
-    {
-        value = std::stoi(str);
-    }
-    catch (const std::invalid_argument &)
-    {
+    std::optional<DealType> deal_type = str.size() == 1 ? deal_type_from_digit(str[0]) : std::nullopt;
+    if (!deal_type.has_value())
         throw std::invalid_argument("Invalid deal type string");
+
+    return deal_type.value();
+}
+
+Card::Card(const std::string &str) : Card(parse(str))
+{
+}
+
+std::string Card::to_string() const
+{
+    return std::string(figure()) + ::to_string<Color>(color());
+}
+
+/*
+ * Card decoding, a card is decoded into its id
+ */
+
+/**
+ * @brief Decode a list of cards in the format <figure><color> into card ids.
+ * @param card_list The list of cards.
+ * @param ids The decoded cards, room for MAX_CARDS_IN_LIST of them.
+ * @param seen Mask of the decoded cards, bit set for every id.
+ * @return The number of cards, or -1 if the list is malformed or longer than MAX_CARDS_IN_LIST.
+ */
+static int decode_cards(std::string_view card_list, uint8_t ids[MAX_CARDS_IN_LIST], uint64_t &seen)
+{
+    int count = 0;
+    seen = 0;
+
+    size_t i = 0;
+    while (i < card_list.size())
+    {
+        int figure = Card::figure_index(card_list[i++]);
+        if (figure == 8 && (i == card_list.size() || card_list[i++] != '0'))
+            return -1;
+        if (figure < 0 || i == card_list.size() || count == MAX_CARDS_IN_LIST)
+            return -1;
+
+        int color = Card::color_index(card_list[i++]);
+        if (color < 0)
+            return -1;
+
+        uint8_t id = color * FIGURES_IN_COLOR + figure;
+        ids[count++] = id;
+        seen |= uint64_t(1) << id;
     }
 
-    if (value < 1 || value > 7)
-        throw std::invalid_argument("Invalid deal type string");
+    return count;
+}
+
+/**
+ * @brief Build cards from their ids.
+ * @param ids The card ids.
+ * @param count The number of cards, at most MAX_CARDS_IN_LIST.
+ * @return The cards.
+ */
+static CardList cards_from_ids(const uint8_t *ids, int count)
+{
+    CardList cards;
+    for (int i = 0; i < count; i++)
+        cards.push_back(Card(ids[i]));
 
-    return static_cast<DealType>(value);
+    return cards;
 }
 
-Card::Card(const std::string &str)
+CardList Card::parse_cards(std::string_view card_list)
 {
-    if (str.size() < 2)
-        throw std::invalid_argument("Invalid card string");
+    uint8_t ids[MAX_CARDS_IN_LIST];
+    uint64_t seen;
+
+    int count = decode_cards(card_list, ids, seen);
+    if (count < 0)
+        throw std::invalid_argument("Invalid card list");
+
+    if (__builtin_popcountll(seen) != count)
+        throw std::invalid_argument("Duplicate cards are not allowed");
 
-    figure = str.substr(0, str.size() - 1);
-    color = from_string<Color>(str.substr(str.size() - 1));
-    validate_and_evaluate();
+    return cards_from_ids(ids, count);
 }
 
-Card::Card(const std::string &figure, Color color) : figure(figure), color(color)
+CardMask cards_to_mask(const CardList &cards)
 {
-    validate_and_evaluate();
+    CardMask mask = 0;
+    for (Card card : cards)
+        mask |= card_mask(card);
+    return mask;
 }
 
-bool Card::operator<(const Card &other) const
+/*
+ * Parsing helpers, malformed input is reported by the return value instead of an exception
+ */
+
+/**
+ * @brief Check if a message starts with a header
+ * @param message The message.
+ * @param header The header.
+ * @return true if the message starts with the header, false otherwise.
+ */
+static bool has_header(std::string_view message, std::string_view header)
 {
-    if (color != other.color)
-    {
-        return color < other.color;
-    }
-    return figure < other.figure;
+    return message.compare(0, header.size(), header) == 0;
+}
+
+/**
+ * @brief Decode a position from its letter.
+ * @param letter The letter of the position.
+ * @param position The decoded position.
+ * @return true if the letter is a position, false otherwise.
+ */
+static bool parse_position(char letter, Position &position)
+{
+    std::optional<Position> decoded = position_from_letter(letter);
+    if (!decoded.has_value())
+        return false;
+
+    position = decoded.value();
+    return true;
 }
 
-bool Card::operator==(const Card &other) const
+/**
+ * @brief Decode a non-negative number written in base 10.
+ * @param digits The digits, at most MAX_NUMBER_DIGITS of them.
+ * @param value The decoded number.
+ * @return true if the digits are a number, false otherwise.
+ */
+static bool parse_number(std::string_view digits, int &value)
 {
-    return this->figure == other.figure && this->color == other.color;
+    if (digits.empty() || digits.size() > MAX_NUMBER_DIGITS)
+        return false;
+
+    value = 0;
+    for (char digit : digits)
+    {
+        if (digit < '0' || digit > '9')
+            return false;
+        value = value * 10 + (digit - '0');
+    }
+
+    return true;
 }
 
-bool Card::compare(const Card &other, Color specialColor) const
+/**
+ * @brief Split the body of a TRICK or TAKEN message into the trick number and cards.
+ *
+ * A number of two digits is taken only if the rest does not fit as a card list after its first digit.
+ *
+ * @param body The body of the message, the trick number followed by cards.
+ * @param trick_number The decoded trick number.
+ * @param cards The decoded cards.
+ * @return true if the body is well formed, false otherwise.
+ */
+static bool parse_trick_body(std::string_view body, int &trick_number, CardList &cards)
 {
-    if (color == other.color)
-        return value < other.value;
+    uint8_t ids[MAX_CARDS_IN_LIST];
+    uint64_t seen;
+
+    size_t digits = 1;
+    int count = decode_cards(body.substr(1), ids, seen);
+    if (count < 0 && body.size() >= 2)
+    {
+        digits = 2;
+        count = decode_cards(body.substr(2), ids, seen);
+    }
 
-    if (color == specialColor)
+    if (count < 0 || !parse_number(body.substr(0, digits), trick_number))
         return false;
-    if (other.color == specialColor)
-        return true;
 
-    return false;
+    if (__builtin_popcountll(seen) != count)
+        throw std::invalid_argument("Duplicate cards are not allowed");
+
+    cards = cards_from_ids(ids, count);
+    return true;
 }
 
-std::string Card::to_string() const
+/*
+ * Serialization helpers, they write into space of the length computed beforehand and return its end
+ */
+
+/**
+ * @brief Count the characters of a number written in base 10.
+ * @param value The number.
+ * @return The number of characters.
+ */
+static size_t number_length(long long value)
 {
-    return figure + ::to_string<Color>(color);
+    long long rest = value;
+    size_t length = 1;
+    if (rest < 0)
+    {
+        rest = -rest;
+        length++;
+    }
+
+    while (rest >= 10)
+    {
+        rest /= 10;
+        length++;
+    }
+
+    return length;
 }
 
-void Card::validate_and_evaluate()
+/**
+ * @brief Write a number in base 10.
+ * @param buffer Space for number_length(value) characters.
+ * @param value The number.
+ * @return The end of the number.
+ */
+static char *write_number(char *buffer, int value)
 {
-    switch (figure[0])
+    long long rest = value;
+    if (rest < 0)
     {
-    case 'J':
-        value = 11;
-        break;
-    case 'Q':
-        value = 12;
-        break;
-    case 'K':
-        value = 13;
-        break;
-    case 'A':
-        value = 14;
-        break;
-    default:
-        try
-        {
-            size_t pos;
-            value = std::stoi(figure, &pos);
-            if (pos != figure.size() || value < 2 || value > 10)
-                throw std::invalid_argument("Invalid figure");
-        }
-        catch (const std::invalid_argument &)
-        {
-            throw std::invalid_argument("Invalid figure");
-        }
+        *buffer++ = '-';
+        rest = -rest;
     }
 
-    if (color != Color::Hearts && color != Color::Diamonds && color != Color::Clubs && color != Color::Spades)
-        throw std::invalid_argument("Invalid color");
+    char *end = buffer + number_length(rest);
+    char *digit = end;
+    do
+    {
+        *--digit = '0' + rest % 10;
+        rest /= 10;
+    } while (rest > 0);
+
+    return end;
+}
+
+/**
+ * @brief Write bytes.
+ * @param buffer Space for the bytes.
+ * @param text The bytes.
+ * @return The end of the bytes.
+ */
+static char *write_text(char *buffer, std::string_view text)
+{
+    memcpy(buffer, text.data(), text.size());
+    return buffer + text.size();
 }
 
-std::vector<Card> Card::parse_cards(const std::string &card_list)
+/**
+ * @brief Count the characters of a list of cards in the format <figure><color>.
+ * @param cards The cards.
+ * @return The number of characters.
+ */
+static size_t cards_length(const CardList &cards)
 {
-    std::vector<Card> cards;
-    std::set<Card> unique_cards;
-    std::regex card_pattern(R"((10|[2-9JQKA])[SHDC])");
-    std::sregex_iterator iter(card_list.begin(), card_list.end(), card_pattern);
-    std::sregex_iterator end;
+    size_t length = 0;
+    for (const Card &card : cards)
+        length += card.figure().size() + 1;
 
-    int total_match_length = 0;
+    return length;
+}
 
-    while (iter != end)
+/**
+ * @brief Write a list of cards in the format <figure><color>.
+ * @param buffer Space for cards_length(cards) characters.
+ * @param cards The cards.
+ * @return The end of the list.
+ */
+static char *write_cards(char *buffer, const CardList &cards)
+{
+    for (const Card &card : cards)
     {
-        try
-        {
-            Card card(iter->str());
-            cards.push_back(card);
-            unique_cards.insert(card);
-            total_match_length += iter->str().length();
-            ++iter;
-        }
-        catch (const std::invalid_argument &e)
-        {
-            throw std::invalid_argument("Invalid card list");
-        }
+        buffer = write_text(buffer, card.figure());
+        *buffer++ = color_letter(card.color());
     }
 
-    if (total_match_length != (int)card_list.length())
+    return buffer;
+}
+
+static const Position SCORE_ORDER[4] = {Position::North, Position::East, Position::South, Position::West};
+
+/**
+ * @brief Count the characters of the values of a SCORE or TOTAL message.
+ * @param values The value of every position.
+ * @return The number of characters.
+ */
+static size_t scores_length(const Scores &values)
+{
+    size_t length = 0;
+    for (Position position : SCORE_ORDER)
+        length += 1 + number_length(values.at(position));
+
+    return length;
+}
+
+/**
+ * @brief Write the values of a SCORE or TOTAL message, every position followed by its value.
+ * @param buffer Space for scores_length(values) characters.
+ * @param values The value of every position.
+ * @return The end of the values.
+ */
+static char *write_scores(char *buffer, const Scores &values)
+{
+    for (Position position : SCORE_ORDER)
     {
-        throw std::invalid_argument("Invalid card list");
+        *buffer++ = position_letter(position);
+        buffer = write_number(buffer, values.at(position));
     }
 
-    if (cards.size() != unique_cards.size())
-        throw std::invalid_argument("Duplicate cards are not allowed");
+    return buffer;
+}
+
+/**
+ * @brief Write the terminator of a message.
+ * @param buffer Space for 2 characters.
+ */
+static void write_terminator(char *buffer)
+{
+    buffer[0] = '\r';
+    buffer[1] = '\n';
+}
+
+/**
+ * @brief Write the length and the type that start a binary frame.
+ * @param buffer Space for 2 bytes.
+ * @param length The length of the whole frame.
+ * @param type The type of the message.
+ * @return The end of the header.
+ */
+static char *write_binary_header(char *buffer, size_t length, MessageType type)
+{
+    buffer[0] = static_cast<char>(length);
+    buffer[1] = static_cast<char>(type);
+    return buffer + 2;
+}
+
+/**
+ * @brief Write a number as 32-bit big-endian.
+ * @param buffer Space for 4 bytes.
+ * @param value The number.
+ * @return The end of the number.
+ */
+static char *write_int32(char *buffer, int value)
+{
+    uint32_t bits = static_cast<uint32_t>(value);
+    for (int i = 0; i < 4; i++)
+        *buffer++ = static_cast<char>(bits >> (24 - 8 * i));
+
+    return buffer;
+}
+
+/**
+ * @brief Read a 32-bit big-endian number.
+ * @param bytes The 4 bytes of the number.
+ * @return The number.
+ */
+static int read_int32(const char *bytes)
+{
+    uint32_t bits = 0;
+    for (int i = 0; i < 4; i++)
+        bits = (bits << 8) | static_cast<unsigned char>(bytes[i]);
+
+    return static_cast<int>(bits);
+}
+
+/**
+ * @brief Write cards as their ids.
+ * @param buffer Space for a byte for every card.
+ * @param cards The cards.
+ * @return The end of the ids.
+ */
+static char *write_card_ids(char *buffer, const CardList &cards)
+{
+    for (const Card &card : cards)
+        *buffer++ = static_cast<char>(card.id());
+
+    return buffer;
+}
+
+/**
+ * @brief Decode cards from their ids.
+ * @param ids The ids, a byte for every card.
+ * @return The cards.
+ * @throws std::invalid_argument If an id is not a card or a card is repeated.
+ */
+static CardList decode_card_ids(std::string_view ids)
+{
+    uint64_t seen = 0;
+    CardList cards;
+
+    for (char byte : ids)
+    {
+        uint8_t id = static_cast<uint8_t>(byte);
+        if (id >= CARDS_IN_DECK || (seen & (uint64_t(1) << id)) != 0)
+            throw std::invalid_argument("Invalid card list");
+        seen |= uint64_t(1) << id;
+        cards.push_back(Card(id));
+    }
 
     return cards;
 }
 
-Message::Message(MessageType type, const std::string &data)
+/**
+ * @brief Write the values of a SCORE or TOTAL message as 32-bit numbers, in the order of the positions.
+ * @param buffer Space for 16 bytes.
+ * @param values The value of every position.
+ * @return The end of the values.
+ */
+static char *write_binary_scores(char *buffer, const Scores &values)
+{
+    for (Position position : SCORE_ORDER)
+        buffer = write_int32(buffer, values.at(position));
+
+    return buffer;
+}
+
+/**
+ * @brief Read the values of a SCORE or TOTAL message written by write_binary_scores.
+ * @param bytes The 16 bytes of the values.
+ * @return The value of every position.
+ */
+static Scores read_binary_scores(const char *bytes)
+{
+    Scores values;
+    for (int i = 0; i < 4; i++)
+        values[SCORE_ORDER[i]] = read_int32(bytes + 4 * i);
+
+    return values;
+}
+
+Message::Message(MessageType type)
 {
     this->type = type;
-    this->data = data;
 }
 
 std::string Message::to_string() const
 {
-    std::string header = ::to_string<MessageType>(type);
-
-    return header + data + "\r\n";
+    std::string str(serialized_size(), '\0');
+    serialize_into(str.data());
+    return str;
 }
 
 std::shared_ptr<Message> Message::from_string(const std::string &str)
 {
-    if (str.size() < 5)
-        throw std::invalid_argument("Invalid message string");
+    AnyMessage message = parse_message(str);
+    return std::visit([](auto &&alternative) -> std::shared_ptr<Message>
+    {
+        return std::make_shared<std::decay_t<decltype(alternative)>>(std::move(alternative));
+    }, message);
+}
 
-    if (str.substr(str.size() - 2) != "\r\n")
-        throw std::invalid_argument("Message string does not end with \\r\\n");
+IAMMessage::IAMMessage(Position position, std::optional<int> table_id, bool binary)
+    : Message(MessageType::IAM), position(position), table_id(table_id), binary(binary)
+{
+    if (table_id.has_value() && table_id.value() < 0)
+        throw std::invalid_argument("Invalid table id");
+}
 
-    std::regex header_pattern("(IAM|BUSY|DEAL|TRICK|WRONG|TAKEN|SCORE|TOTAL)");
-
-    if (!std::regex_search(str.begin(), str.begin() + 5, header_pattern))
-        throw std::invalid_argument("Invalid message header");
-
-    std::string new_str = str.substr(0, str.size() - 2);
-
-    if (new_str.substr(0, 3) == "IAM")
-        return IAMMessage::from_string(new_str);
-    if (new_str.substr(0, 4) == "BUSY")
-        return BUSYMessage::from_string(new_str);
-    if (new_str.substr(0, 4) == "DEAL")
-        return DEALMessage::from_string(new_str);
-    if (new_str.substr(0, 5) == "TRICK")
-        return TRICKMessage::from_string(new_str);
-    if (new_str.substr(0, 5) == "WRONG")
-        return WRONGMessage::from_string(new_str);
-    if (new_str.substr(0, 5) == "TAKEN")
-        return TAKENMessage::from_string(new_str);
-    if (new_str.substr(0, 5) == "SCORE")
-        return SCOREMessage::from_string(new_str);
-    if (new_str.substr(0, 5) == "TOTAL")
-        return TOTALMessage::from_string(new_str);
+size_t IAMMessage::serialized_size() const
+{
+    return 4 + (table_id.has_value() ? number_length(table_id.value()) : 0) + (binary ? 1 : 0) + 2;
+}
 
-    throw std::invalid_argument("Invalid message header");
+void IAMMessage::serialize_into(char *buffer) const
+{
+    buffer = write_text(buffer, "IAM");
+    *buffer++ = position_letter(position);
+    if (table_id.has_value())
+        buffer = write_number(buffer, table_id.value());
+    if (binary)
+        *buffer++ = 'B';
+    write_terminator(buffer);
 }
 
-IAMMessage::IAMMessage(Position position)
-    : Message(MessageType::IAM, std::string(1, static_cast<char>(position))), position(position)
+size_t IAMMessage::binary_size() const
 {
+    return 3 + (table_id.has_value() ? 4 : 0);
 }
 
-std::shared_ptr<IAMMessage> IAMMessage::from_string(const std::string &str)
+void IAMMessage::serialize_binary_into(char *buffer) const
 {
-    if (str.size() != 4)
+    buffer = write_binary_header(buffer, binary_size(), MessageType::IAM);
+    *buffer++ = position_letter(position);
+    if (table_id.has_value())
+        write_int32(buffer, table_id.value());
+}
+
+IAMMessage IAMMessage::parse(std::string_view str)
+{
+    bool binary = str.size() > 4 && str.back() == 'B';
+    if (binary)
+        str.remove_suffix(1);
+
+    Position position;
+    if (str.size() < 4 || str.size() > 4 + MAX_TABLE_ID_DIGITS || !parse_position(str[3], position))
         throw std::invalid_argument("Invalid IAM message string");
 
-    Position position = ::from_string<Position>(str.substr(3, 1));
+    if (str.size() == 4)
+        return IAMMessage(position, std::nullopt, binary);
 
-    return std::make_shared<IAMMessage>(position);
+    int table_id;
+    if ((str[4] == '0' && str.size() > 5) || !parse_number(str.substr(4), table_id))
+        throw std::invalid_argument("Invalid IAM message string");
+
+    return IAMMessage(position, table_id, binary);
 }
 
-BUSYMessage::BUSYMessage(std::vector<Position> positions)
-    : Message(MessageType::BUSY, "")
+std::shared_ptr<IAMMessage> IAMMessage::from_string(std::string_view str)
+{
+    return std::make_shared<IAMMessage>(parse(str));
+}
+
+BUSYMessage::BUSYMessage(const PositionList &positions)
+    : Message(MessageType::BUSY)
 {
-    for (Position position : positions)
-        this->data += ::to_string<Position>(position);
     this->positions = positions;
 }
 
-std::shared_ptr<BUSYMessage> BUSYMessage::from_string(const std::string &str)
+size_t BUSYMessage::serialized_size() const
+{
+    return 4 + positions.size() + 2;
+}
+
+void BUSYMessage::serialize_into(char *buffer) const
+{
+    buffer = write_text(buffer, "BUSY");
+    for (Position position : positions)
+        *buffer++ = position_letter(position);
+    write_terminator(buffer);
+}
+
+size_t BUSYMessage::binary_size() const
+{
+    return 2 + positions.size();
+}
+
+void BUSYMessage::serialize_binary_into(char *buffer) const
+{
+    buffer = write_binary_header(buffer, binary_size(), MessageType::BUSY);
+    for (Position position : positions)
+        *buffer++ = position_letter(position);
+}
+
+BUSYMessage BUSYMessage::parse(std::string_view str)
 {
     if (str.size() < 4 || str.size() > 8)
         throw std::invalid_argument("Invalid BUSY message string");
 
-    std::vector<Position> positions;
-    std::set<Position> unique_positions;
+    PositionList positions;
     for (size_t i = 4; i < str.size(); i++)
     {
-        Position position = ::from_string<Position>(str.substr(i, 1));
+        Position position;
+        if (!parse_position(str[i], position))
+            throw std::invalid_argument("Invalid position string");
+        if (positions.contains(position))
+            throw std::invalid_argument("Duplicate positions are not allowed");
         positions.push_back(position);
-        unique_positions.insert(position);
     }
 
-    if (positions.size() != unique_positions.size())
-        throw std::invalid_argument("Duplicate positions are not allowed");
+    return BUSYMessage(positions);
+}
 
-    return std::make_shared<BUSYMessage>(positions);
+std::shared_ptr<BUSYMessage> BUSYMessage::from_string(std::string_view str)
+{
+    return std::make_shared<BUSYMessage>(parse(str));
 }
 
-DEALMessage::DEALMessage(DealType deal_type, Position first_player, const std::vector<Card> &cards)
-    : Message(MessageType::DEAL, "")
+DEALMessage::DEALMessage(DealType deal_type, Position first_player, const CardList &cards)
+    : Message(MessageType::DEAL)
 {
-    this->data += ::to_string<DealType>(deal_type);
-    this->data += ::to_string<Position>(first_player);
     if (cards.size() != 13)
         throw std::invalid_argument("Invalid number of cards in the deal");
-    for (const Card &card : cards)
-        this->data += card.to_string();
     this->type = deal_type;
     this->first_player = first_player;
     this->cards = cards;
 }
 
-std::shared_ptr<DEALMessage> DEALMessage::from_string(const std::string &str)
+size_t DEALMessage::serialized_size() const
+{
+    return 6 + cards_length(cards) + 2;
+}
+
+void DEALMessage::serialize_into(char *buffer) const
+{
+    buffer = write_text(buffer, "DEAL");
+    *buffer++ = deal_type_digit(type);
+    *buffer++ = position_letter(first_player);
+    buffer = write_cards(buffer, cards);
+    write_terminator(buffer);
+}
+
+size_t DEALMessage::binary_size() const
 {
-    if (str.size() < 8)
+    return 4 + cards.size();
+}
+
+void DEALMessage::serialize_binary_into(char *buffer) const
+{
+    buffer = write_binary_header(buffer, binary_size(), MessageType::DEAL);
+    *buffer++ = static_cast<char>(type);
+    *buffer++ = position_letter(first_player);
+    write_card_ids(buffer, cards);
+}
+
+DEALMessage DEALMessage::parse(std::string_view str)
+{
+    Position starting_player;
+    std::optional<DealType> deal_type = str.size() < 8 ? std::nullopt : deal_type_from_digit(str[4]);
+    if (!deal_type.has_value() || !parse_position(str[5], starting_player))
         throw std::invalid_argument("Invalid DEAL message string");
 
-    DealType deal_type = ::from_string<DealType>(str.substr(4, 1));
-    Position starting_player = ::from_string<Position>(str.substr(5, 1));
-    std::vector<Card> cards = Card::parse_cards(str.substr(6));
+    CardList cards = Card::parse_cards(str.substr(6));
 
-    return std::make_shared<DEALMessage>(deal_type, starting_player, cards);
+    return DEALMessage(deal_type.value(), starting_player, cards);
 }
 
-TRICKMessage::TRICKMessage(int trick_number, const std::vector<Card> &cards)
-    : Message(MessageType::TRICK, "")
+std::shared_ptr<DEALMessage> DEALMessage::from_string(std::string_view str)
+{
+    return std::make_shared<DEALMessage>(parse(str));
+}
+
+TRICKMessage::TRICKMessage(int trick_number, const CardList &cards)
+    : Message(MessageType::TRICK)
 {
     if (trick_number < 1 || trick_number > 13)
         throw std::invalid_argument("Invalid trick number");
@@ -370,73 +704,100 @@ TRICKMessage::TRICKMessage(int trick_number, const std::vector<Card> &cards)
     if (cards.size() > 3)
         throw std::invalid_argument("Too many cards in the trick");
 
-    this->data += std::to_string(trick_number);
-    for (const Card &card : cards)
-        this->data += card.to_string();
-
     this->trick_number = trick_number;
     this->cards = cards;
 }
 
-std::shared_ptr<TRICKMessage> TRICKMessage::from_string(const std::string &str)
+size_t TRICKMessage::serialized_size() const
+{
+    return 5 + number_length(trick_number) + cards_length(cards) + 2;
+}
+
+void TRICKMessage::serialize_into(char *buffer) const
+{
+    buffer = write_text(buffer, "TRICK");
+    buffer = write_number(buffer, trick_number);
+    buffer = write_cards(buffer, cards);
+    write_terminator(buffer);
+}
+
+size_t TRICKMessage::binary_size() const
+{
+    return 3 + cards.size();
+}
+
+void TRICKMessage::serialize_binary_into(char *buffer) const
+{
+    buffer = write_binary_header(buffer, binary_size(), MessageType::TRICK);
+    *buffer++ = static_cast<char>(trick_number);
+    write_card_ids(buffer, cards);
+}
+
+TRICKMessage TRICKMessage::parse(std::string_view str)
 {
     if (str.size() < 6)
         throw std::invalid_argument("Invalid TRICK message string");
 
+    std::string_view body = str.substr(5);
     int trick_number;
-    std::vector<Card> cards;
+    CardList cards;
+    if (!parse_trick_body(body, trick_number, cards))
+        throw std::invalid_argument("Invalid TRICK message string");
 
-    try
-    {
-        trick_number = std::stoi(str.substr(5, 1));
-        cards = Card::parse_cards(str.substr(6));
-    }
-    catch (const std::invalid_argument &)
-    {
-        try
-        {
-            trick_number = std::stoi(str.substr(5, 2));
-            cards = Card::parse_cards(str.substr(7));
-        }
-        catch (const std::invalid_argument &)
-        {
-            throw std::invalid_argument("Invalid TRICK message string");
-        }
-    }
+    return TRICKMessage(trick_number, cards);
+}
 
-    return std::make_shared<TRICKMessage>(trick_number, cards);
+std::shared_ptr<TRICKMessage> TRICKMessage::from_string(std::string_view str)
+{
+    return std::make_shared<TRICKMessage>(parse(str));
 }
 
 WRONGMessage::WRONGMessage(int trick_number)
-    : Message(MessageType::WRONG, std::to_string(trick_number)), trick_number(trick_number)
+    : Message(MessageType::WRONG), trick_number(trick_number)
 {
     if (trick_number < 1 || trick_number > 13)
         throw std::invalid_argument("Invalid trick number");
 }
 
-std::shared_ptr<WRONGMessage> WRONGMessage::from_string(const std::string &str)
+size_t WRONGMessage::serialized_size() const
 {
-    if (str.size() < 6 || str.size() > 7)
-        throw std::invalid_argument("Invalid WRONG message string");
+    return 5 + number_length(trick_number) + 2;
+}
+
+void WRONGMessage::serialize_into(char *buffer) const
+{
+    buffer = write_text(buffer, "WRONG");
+    buffer = write_number(buffer, trick_number);
+    write_terminator(buffer);
+}
+
+size_t WRONGMessage::binary_size() const
+{
+    return 3;
+}
 
+void WRONGMessage::serialize_binary_into(char *buffer) const
+{
+    buffer = write_binary_header(buffer, binary_size(), MessageType::WRONG);
+    *buffer = static_cast<char>(trick_number);
+}
+
+WRONGMessage WRONGMessage::parse(std::string_view str)
+{
     int trick_number;
-    try
-    {
-        size_t pos;
-        trick_number = std::stoi(str.substr(5), &pos);
-        if (pos != str.substr(5).size())
-            throw std::invalid_argument("Invalid WRONG message string");
-    }
-    catch (const std::invalid_argument &)
-    {
+    if (str.size() < 6 || str.size() > 7 || !parse_number(str.substr(5), trick_number))
         throw std::invalid_argument("Invalid WRONG message string");
-    }
 
-    return std::make_shared<WRONGMessage>(trick_number);
+    return WRONGMessage(trick_number);
+}
+
+std::shared_ptr<WRONGMessage> WRONGMessage::from_string(std::string_view str)
+{
+    return std::make_shared<WRONGMessage>(parse(str));
 }
 
-TAKENMessage::TAKENMessage(int trick_number, const std::vector<Card> &cards, Position taken_by)
-    : Message(MessageType::TAKEN, "")
+TAKENMessage::TAKENMessage(int trick_number, const CardList &cards, Position taken_by)
+    : Message(MessageType::TAKEN)
 {
     if (trick_number < 1 || trick_number > 13)
         throw std::invalid_argument("Invalid trick number");
@@ -444,74 +805,102 @@ TAKENMessage::TAKENMessage(int trick_number, const std::vector<Card> &cards, Pos
     if (cards.size() != 4)
         throw std::invalid_argument("Invalid number of cards in the trick");
 
-    this->data += std::to_string(trick_number);
-    for (const Card &card : cards)
-        this->data += card.to_string();
-    this->data += ::to_string<Position>(taken_by);
-
     this->trick_number = trick_number;
     this->cards = cards;
     this->taken_by = taken_by;
 }
 
-std::shared_ptr<TAKENMessage> TAKENMessage::from_string(const std::string &str)
+size_t TAKENMessage::serialized_size() const
+{
+    return 5 + number_length(trick_number) + cards_length(cards) + 1 + 2;
+}
+
+void TAKENMessage::serialize_into(char *buffer) const
 {
-    if (str.size() < 9)
+    buffer = write_text(buffer, "TAKEN");
+    buffer = write_number(buffer, trick_number);
+    buffer = write_cards(buffer, cards);
+    *buffer++ = position_letter(taken_by);
+    write_terminator(buffer);
+}
+
+size_t TAKENMessage::binary_size() const
+{
+    return 4 + cards.size();
+}
+
+void TAKENMessage::serialize_binary_into(char *buffer) const
+{
+    buffer = write_binary_header(buffer, binary_size(), MessageType::TAKEN);
+    *buffer++ = static_cast<char>(trick_number);
+    buffer = write_card_ids(buffer, cards);
+    *buffer = position_letter(taken_by);
+}
+
+TAKENMessage TAKENMessage::parse(std::string_view str)
+{
+    Position taken_by;
+    if (str.size() < 9 || !parse_position(str.back(), taken_by))
         throw std::invalid_argument("Invalid TAKEN message string");
 
+    std::string_view body = str.substr(5, str.size() - 6);
     int trick_number;
-    std::vector<Card> cards;
-    Position taken_by;
+    CardList cards;
+    if (!parse_trick_body(body, trick_number, cards))
+        throw std::invalid_argument("Invalid TAKEN message string");
 
-    try
-    {
-        trick_number = std::stoi(str.substr(5, 1));
-        cards = Card::parse_cards(str.substr(6, str.size() - 7));
-        taken_by = ::from_string<Position>(str.substr(str.size() - 1));
-    }
-    catch (const std::invalid_argument &)
-    {
-        try
-        {
-            trick_number = std::stoi(str.substr(5, 2));
-            cards = Card::parse_cards(str.substr(7, str.size() - 8));
-            taken_by = ::from_string<Position>(str.substr(str.size() - 1));
-        }
-        catch (const std::invalid_argument &)
-        {
-            throw std::invalid_argument("Invalid TAKEN message string");
-        }
-    }
+    return TAKENMessage(trick_number, cards, taken_by);
+}
 
-    return std::make_shared<TAKENMessage>(trick_number, cards, taken_by);
+std::shared_ptr<TAKENMessage> TAKENMessage::from_string(std::string_view str)
+{
+    return std::make_shared<TAKENMessage>(parse(str));
 }
 
+/**
+ * @brief Parse a SCORE or TOTAL message, every position followed by its number exactly once, in any order.
+ * @tparam T The type of the message.
+ * @param str The message without the terminator.
+ * @return T The parsed message.
+ */
 template <typename T>
-std::shared_ptr<T> parse_score_message(const std::string &str, const std::string &regex_str)
+T parse_score_message(std::string_view str)
 {
-    std::regex message_regex(regex_str);
-    std::smatch match;
+    Scores values;
+    unsigned seen = 0;
 
-    if (!std::regex_match(str, match, message_regex))
+    size_t i = 5;
+    while (i < str.size())
     {
-        throw std::invalid_argument("Invalid message string");
-    }
+        Position position;
+        if (!parse_position(str[i], position) || (seen & (1u << position_index(position))) != 0)
+            throw std::invalid_argument("Invalid message string");
+        seen |= 1u << position_index(position);
 
-    std::map<Position, int> values;
-    for (size_t i = 1; i < match.size(); i++)
-    {
-        if (match[i].str().empty())
-            continue;
-        Position position = ::from_string<Position>(std::string(1, match[i].str()[0]));
-        int value = std::stoi(match[i].str().substr(1));
-        values[position] = value;
+        size_t digits_end = i + 1;
+        while (digits_end < str.size() && str[digits_end] >= '0' && str[digits_end] <= '9')
+            digits_end++;
+
+        if (!parse_number(str.substr(i + 1, digits_end - i - 1), values[position]))
+            throw std::invalid_argument("Invalid message string");
+
+        i = digits_end;
     }
 
-    return std::make_shared<T>(values);
+    if (seen != (1u << POSITIONS_COUNT) - 1)
+        throw std::invalid_argument("Invalid message string");
+
+    return T(values);
+}
+
+SCOREMessage::SCOREMessage(const Scores &scores)
+    : Message(MessageType::SCORE)
+{
+    this->scores = scores;
 }
 
 SCOREMessage::SCOREMessage(const std::map<Position, int> &scores)
-    : Message(MessageType::SCORE, "")
+    : Message(MessageType::SCORE)
 {
     if (scores.size() != 4)
     {
@@ -520,25 +909,56 @@ SCOREMessage::SCOREMessage(const std::map<Position, int> &scores)
 
     for (auto pos : {Position::North, Position::East, Position::South, Position::West})
     {
-        auto it = scores.find(pos);
-        if (it == scores.end())
+        if (scores.find(pos) == scores.end())
         {
             throw std::invalid_argument("Missing score for position");
         }
-        this->data += ::to_string<Position>(pos);
-        this->data += std::to_string(it->second);
+
+        this->scores[pos] = scores.at(pos);
     }
+}
 
-    this->scores = scores;
+size_t SCOREMessage::serialized_size() const
+{
+    return 5 + scores_length(scores) + 2;
 }
 
-std::shared_ptr<SCOREMessage> SCOREMessage::from_string(const std::string &str)
+void SCOREMessage::serialize_into(char *buffer) const
 {
-    return parse_score_message<SCOREMessage>(str, "^SCORE((N[0-9]{1,})|(E[0-9]{1,})|(S[0-9]{1,})|(W[0-9]{1,})){4}$");
+    buffer = write_text(buffer, "SCORE");
+    buffer = write_scores(buffer, scores);
+    write_terminator(buffer);
+}
+
+size_t SCOREMessage::binary_size() const
+{
+    return 2 + 16;
+}
+
+void SCOREMessage::serialize_binary_into(char *buffer) const
+{
+    buffer = write_binary_header(buffer, binary_size(), MessageType::SCORE);
+    write_binary_scores(buffer, scores);
+}
+
+SCOREMessage SCOREMessage::parse(std::string_view str)
+{
+    return parse_score_message<SCOREMessage>(str);
+}
+
+std::shared_ptr<SCOREMessage> SCOREMessage::from_string(std::string_view str)
+{
+    return std::make_shared<SCOREMessage>(parse(str));
+}
+
+TOTALMessage::TOTALMessage(const Scores &totals)
+    : Message(MessageType::TOTAL)
+{
+    this->totals = totals;
 }
 
 TOTALMessage::TOTALMessage(const std::map<Position, int> &totals)
-    : Message(MessageType::TOTAL, "")
+    : Message(MessageType::TOTAL)
 {
     if (totals.size() != 4)
     {
@@ -547,19 +967,160 @@ TOTALMessage::TOTALMessage(const std::map<Position, int> &totals)
 
     for (auto pos : {Position::North, Position::East, Position::South, Position::West})
     {
-        auto it = totals.find(pos);
-        if (it == totals.end())
+        if (totals.find(pos) == totals.end())
         {
             throw std::invalid_argument("Missing total for position");
         }
-        this->data += ::to_string<Position>(pos);
-        this->data += std::to_string(it->second);
+
+        this->totals[pos] = totals.at(pos);
     }
+}
 
-    this->totals = totals;
+size_t TOTALMessage::serialized_size() const
+{
+    return 5 + scores_length(totals) + 2;
 }
 
-std::shared_ptr<TOTALMessage> TOTALMessage::from_string(const std::string &str)
+void TOTALMessage::serialize_into(char *buffer) const
 {
-    return parse_score_message<TOTALMessage>(str, "^TOTAL((N[0-9]{1,})|(E[0-9]{1,})|(S[0-9]{1,})|(W[0-9]{1,})){4}$");
+    buffer = write_text(buffer, "TOTAL");
+    buffer = write_scores(buffer, totals);
+    write_terminator(buffer);
 }
+
+size_t TOTALMessage::binary_size() const
+{
+    return 2 + 16;
+}
+
+void TOTALMessage::serialize_binary_into(char *buffer) const
+{
+    buffer = write_binary_header(buffer, binary_size(), MessageType::TOTAL);
+    write_binary_scores(buffer, totals);
+}
+
+TOTALMessage TOTALMessage::parse(std::string_view str)
+{
+    return parse_score_message<TOTALMessage>(str);
+}
+
+std::shared_ptr<TOTALMessage> TOTALMessage::from_string(std::string_view str)
+{
+    return std::make_shared<TOTALMessage>(parse(str));
+}
+
+/**
+ * @brief Parse a binary frame.
+ * @param frame The frame, its length included.
+ * @return AnyMessage The parsed message.
+ */
+static AnyMessage parse_binary_message(std::string_view frame)
+{
+    if (frame.size() < 2 || static_cast<unsigned char>(frame[0]) != frame.size())
+        throw std::invalid_argument("Invalid binary frame");
+
+    std::string_view payload = frame.substr(2);
+    Position position;
+
+    switch (static_cast<MessageType>(frame[1]))
+    {
+    case MessageType::IAM:
+        if ((payload.size() != 1 && payload.size() != 5) || !parse_position(payload[0], position))
+            break;
+        if (payload.size() == 1)
+            return IAMMessage(position, std::nullopt, true);
+        return IAMMessage(position, read_int32(payload.data() + 1), true);
+    case MessageType::BUSY:
+    {
+        if (payload.size() > 4)
+            break;
+        PositionList positions;
+        for (char letter : payload)
+        {
+            if (!parse_position(letter, position) || positions.contains(position))
+                throw std::invalid_argument("Invalid binary frame");
+            positions.push_back(position);
+        }
+        return BUSYMessage(positions);
+    }
+    case MessageType::DEAL:
+        if (payload.size() != 15 || payload[0] < 1 || payload[0] > 7 || !parse_position(payload[1], position))
+            break;
+        return DEALMessage(static_cast<DealType>(payload[0]), position, decode_card_ids(payload.substr(2)));
+    case MessageType::TRICK:
+        if (payload.empty())
+            break;
+        return TRICKMessage(static_cast<unsigned char>(payload[0]), decode_card_ids(payload.substr(1)));
+    case MessageType::WRONG:
+        if (payload.size() != 1)
+            break;
+        return WRONGMessage(static_cast<unsigned char>(payload[0]));
+    case MessageType::TAKEN:
+        if (payload.size() != 6 || !parse_position(payload[5], position))
+            break;
+        return TAKENMessage(static_cast<unsigned char>(payload[0]), decode_card_ids(payload.substr(1, 4)), position);
+    case MessageType::SCORE:
+        if (payload.size() != 16)
+            break;
+        return SCOREMessage(read_binary_scores(payload.data()));
+    case MessageType::TOTAL:
+        if (payload.size() != 16)
+            break;
+        return TOTALMessage(read_binary_scores(payload.data()));
+    }
+
+    throw std::invalid_argument("Invalid binary frame");
+}
+
+AnyMessage parse_message(std::string_view str, bool binary)
+{
+    bool frame = !str.empty() && is_binary_frame(str[0]);
+    if (frame != binary)
+        throw std::invalid_argument(binary ? "Text message on a binary connection" : "Binary frame on a text connection");
+
+    if (binary)
+        return parse_binary_message(str);
+
+    if (str.size() < 5)
+        throw std::invalid_argument("Invalid message string");
+
+    if (str[str.size() - 2] != '\r' || str[str.size() - 1] != '\n')
+        throw std::invalid_argument("Message string does not end with \\r\\n");
+
+    // The type is told by the first bytes, parsers of the types get the message without the terminator.
+    std::string_view message = str.substr(0, str.size() - 2);
+
+    switch (message[0])
+    {
+    case 'I':
+        if (has_header(message, "IAM"))
+            return IAMMessage::parse(message);
+        break;
+    case 'B':
+        if (has_header(message, "BUSY"))
+            return BUSYMessage::parse(message);
+        break;
+    case 'D':
+        if (has_header(message, "DEAL"))
+            return DEALMessage::parse(message);
+        break;
+    case 'T':
+        if (has_header(message, "TRICK"))
+            return TRICKMessage::parse(message);
+        if (has_header(message, "TAKEN"))
+            return TAKENMessage::parse(message);
+        if (has_header(message, "TOTAL"))
+            return TOTALMessage::parse(message);
+        break;
+    case 'W':
+        if (has_header(message, "WRONG"))
+            return WRONGMessage::parse(message);
+        break;
+    case 'S':
+        if (has_header(message, "SCORE"))
+            return SCOREMessage::parse(message);
+        break;
+    }
+
+    throw std::invalid_argument("Invalid message header");
+}
\ No newline at end of file
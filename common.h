@@ -1,11 +1,25 @@
 #ifndef COMMON_H
 #define COMMON_H
 
+#include <array>
+#include <cstdint>
+#include <initializer_list>
+#include <iterator>
 #include <string>
+#include <string_view>
 #include <vector>
 #include <stdexcept>
 #include <map>
 #include <memory>
+#include <optional>
+#include <variant>
+
+#define MAX_TABLE_ID_DIGITS 9
+#define MAX_CARDS_IN_LIST 13
+#define FIGURES_IN_COLOR 13
+#define CARDS_IN_DECK 52
+#define MAX_BINARY_FRAME_SIZE 31
+#define POSITIONS_COUNT 4
 
 /**
  * @brief Converts a value to a string.
@@ -52,6 +66,35 @@ std::string to_string(Color color);
 template <>
 Color from_string(const std::string &str);
 
+/**
+ * @brief Gets the letter of a color.
+ * @param color The color.
+ * @return char The letter of the color.
+ */
+constexpr char color_letter(Color color)
+{
+    return static_cast<char>(color);
+}
+
+/**
+ * @brief Decodes a color from its letter.
+ * @param letter The letter.
+ * @return std::optional<Color> The color, empty if the letter is not a color.
+ */
+constexpr std::optional<Color> color_from_letter(char letter)
+{
+    switch (letter)
+    {
+    case 'H':
+    case 'D':
+    case 'C':
+    case 'S':
+        return static_cast<Color>(letter);
+    default:
+        return std::nullopt;
+    }
+}
+
 /**
  * @brief Enum class for different types of messages.
  */
@@ -83,6 +126,66 @@ std::string to_string(MessageType type);
 template <>
 MessageType from_string(const std::string &str);
 
+/**
+ * @brief Headers of the message types, indexed by MessageType.
+ */
+inline constexpr std::string_view MESSAGE_TYPE_HEADERS[] = {"IAM", "BUSY", "DEAL", "TRICK", "WRONG", "TAKEN", "SCORE", "TOTAL"};
+
+/**
+ * @brief Gets the header of a MessageType.
+ * @param type The MessageType.
+ * @return std::string_view The header, empty if the type is not valid.
+ */
+constexpr std::string_view message_type_header(MessageType type)
+{
+    size_t index = static_cast<size_t>(type);
+    return index < std::size(MESSAGE_TYPE_HEADERS) ? MESSAGE_TYPE_HEADERS[index] : std::string_view();
+}
+
+/**
+ * @brief Decodes a MessageType from its header.
+ *
+ * The candidate type is picked by the first letter and, among the headers
+ * starting with T, by the second one, so only one header is compared.
+ *
+ * @param header The header.
+ * @return std::optional<MessageType> The MessageType, empty if the header is not valid.
+ */
+constexpr std::optional<MessageType> message_type_from_header(std::string_view header)
+{
+    if (header.size() < 3)
+        return std::nullopt;
+
+    MessageType type = MessageType::IAM;
+    switch (header[0])
+    {
+    case 'I':
+        type = MessageType::IAM;
+        break;
+    case 'B':
+        type = MessageType::BUSY;
+        break;
+    case 'D':
+        type = MessageType::DEAL;
+        break;
+    case 'W':
+        type = MessageType::WRONG;
+        break;
+    case 'S':
+        type = MessageType::SCORE;
+        break;
+    case 'T':
+        type = header[1] == 'R' ? MessageType::TRICK : header[1] == 'A' ? MessageType::TAKEN : MessageType::TOTAL;
+        break;
+    default:
+        return std::nullopt;
+    }
+
+    if (header != message_type_header(type))
+        return std::nullopt;
+    return type;
+}
+
 /**
  * @brief An enumeration of possible player positions.
  */
@@ -110,6 +213,185 @@ std::string to_string(Position position);
 template <>
 Position from_string(const std::string &str);
 
+/**
+ * @brief Gets the letter of a Position.
+ * @param position The Position.
+ * @return char The letter of the Position.
+ */
+constexpr char position_letter(Position position)
+{
+    return static_cast<char>(position);
+}
+
+/**
+ * @brief Decodes a Position from its letter.
+ * @param letter The letter.
+ * @return std::optional<Position> The Position, empty if the letter is not a position.
+ */
+constexpr std::optional<Position> position_from_letter(char letter)
+{
+    switch (letter)
+    {
+    case 'N':
+    case 'E':
+    case 'S':
+    case 'W':
+        return static_cast<Position>(letter);
+    default:
+        return std::nullopt;
+    }
+}
+
+/**
+ * @brief Gets the index of a Position in the order of the table.
+ * @param position The Position.
+ * @return int The index, 0 for North, 1 for East, 2 for South and 3 for West.
+ */
+constexpr int position_index(Position position)
+{
+    switch (position)
+    {
+    case Position::North:
+        return 0;
+    case Position::East:
+        return 1;
+    case Position::South:
+        return 2;
+    case Position::West:
+        return 3;
+    }
+    return 0;
+}
+
+/**
+ * @brief List of at most Capacity values stored in place, it never allocates.
+ * @tparam T The type of the values, default constructible.
+ * @tparam Capacity The maximum number of values.
+ */
+template <typename T, size_t Capacity>
+class FixedList
+{
+public:
+    using value_type = T;
+    using iterator = const T *;
+    using const_iterator = const T *;
+
+    /**
+     * @brief Constructs an empty list.
+     */
+    constexpr FixedList() : items{}, count(0) {}
+
+    /**
+     * @brief Constructs a list of the given values.
+     * @param values The values.
+     * @throws std::invalid_argument If there are more than Capacity values.
+     */
+    constexpr FixedList(std::initializer_list<T> values) : FixedList()
+    {
+        for (const T &value : values)
+            push_back(value);
+    }
+
+    /**
+     * @brief Constructs a list of the values of a vector.
+     * @param values The values.
+     * @throws std::invalid_argument If there are more than Capacity values.
+     */
+    FixedList(const std::vector<T> &values) : FixedList()
+    {
+        for (const T &value : values)
+            push_back(value);
+    }
+
+    /**
+     * @brief Appends a value.
+     * @param value The value.
+     * @throws std::invalid_argument If the list is full.
+     */
+    constexpr void push_back(const T &value)
+    {
+        if (count == Capacity)
+            throw std::invalid_argument("Too many values in the list");
+        items[count++] = value;
+    }
+
+    constexpr size_t size() const { return count; }
+    constexpr bool empty() const { return count == 0; }
+    constexpr const T *begin() const { return items.data(); }
+    constexpr const T *end() const { return items.data() + count; }
+    constexpr const T &operator[](size_t idx) const { return items[idx]; }
+
+    /**
+     * @brief Checks if the list contains a value.
+     * @param value The value.
+     * @return true if the value is in the list, false otherwise.
+     */
+    constexpr bool contains(const T &value) const
+    {
+        for (const T &item : *this)
+            if (item == value)
+                return true;
+        return false;
+    }
+
+    /**
+     * @brief Compares two lists value by value.
+     * @param first The first list.
+     * @param second The second list.
+     * @return true if both lists hold the same values in the same order, false otherwise.
+     */
+    friend constexpr bool operator==(const FixedList &first, const FixedList &second)
+    {
+        if (first.count != second.count)
+            return false;
+        for (size_t i = 0; i < first.count; i++)
+            if (!(first.items[i] == second.items[i]))
+                return false;
+        return true;
+    }
+
+    friend constexpr bool operator!=(const FixedList &first, const FixedList &second)
+    {
+        return !(first == second);
+    }
+
+private:
+    std::array<T, Capacity> items;
+    size_t count;
+};
+
+/**
+ * @brief List of distinct positions, as in a BUSY message.
+ */
+using PositionList = FixedList<Position, POSITIONS_COUNT>;
+
+/**
+ * @brief Points of every position, stored in place and indexed by position_index.
+ */
+class Scores
+{
+public:
+    /**
+     * @brief Constructs scores of 0 for every position.
+     */
+    constexpr Scores() : values{} {}
+
+    constexpr int &operator[](Position position) { return values[position_index(position)]; }
+    constexpr int operator[](Position position) const { return values[position_index(position)]; }
+
+    /**
+     * @brief Gets the points of a position.
+     * @param position The position.
+     * @return int The points.
+     */
+    constexpr int at(Position position) const { return values[position_index(position)]; }
+
+    bool operator==(const Scores &other) const { return values == other.values; }
+
+private:
+    std::array<int, POSITIONS_COUNT> values;
+};
+
 /**
  * @brief Enum class for different types of deals.
  */
@@ -140,15 +422,37 @@ std::string to_string(DealType type);
 template <>
 DealType from_string(const std::string &str);
 
+/**
+ * @brief Gets the digit of a DealType.
+ * @param type The DealType.
+ * @return char The digit of the DealType.
+ */
+constexpr char deal_type_digit(DealType type)
+{
+    return static_cast<char>('0' + static_cast<int>(type));
+}
+
+/**
+ * @brief Decodes a DealType from its digit.
+ * @param digit The digit.
+ * @return std::optional<DealType> The DealType, empty if the digit is not a deal type.
+ */
+constexpr std::optional<DealType> deal_type_from_digit(char digit)
+{
+    if (digit < '1' || digit > '7')
+        return std::nullopt;
+    return static_cast<DealType>(digit - '0');
+}
+
 /**
  * @brief Represents a playing card.
+ *
+ * The card is packed into one byte, its id is the color index (clubs, diamonds, hearts, spades)
+ * times FIGURES_IN_COLOR plus the figure index (2 to ace).
  */
 class Card
 {
 public:
-    std::string figure;
-    Color color;
-
     /**
      * @brief Constructs a Card from a string.
      * @param str The string representation of the card.
@@ -157,25 +461,123 @@ public:
     Card(const std::string &str);
 
     /**
-     * @brief Constructs a Card with the given figure and color.
-     * @param figure The figure of the card.
-     * @param color The color of the card.
+     * @brief Constructs the two of clubs, a placeholder for the free slots of a CardList.
+     */
+    constexpr Card() : card_id(0) {}
+
+    /**
+     * @brief Constructs a Card from its id.
+     * @param id The id of the card, less than CARDS_IN_DECK.
+     */
+    constexpr explicit Card(uint8_t id) : card_id(id) {}
+
+    /**
+     * @brief Parses a card from its string representation.
+     * @param str The string representation of the card.
+     * @return Card The parsed card.
+     * @throws std::invalid_argument If the string is not a valid card representation.
+     */
+    static constexpr Card parse(std::string_view str)
+    {
+        if (str.size() < 2 || str.size() > 3)
+            throw std::invalid_argument("Invalid card string");
+
+        int figure = figure_index(str[0]);
+        if (figure < 0 || (figure == 8) != (str.size() == 3) || (figure == 8 && str[1] != '0'))
+            throw std::invalid_argument("Invalid figure");
+
+        int color = color_index(str.back());
+        if (color < 0)
+            throw std::invalid_argument("Invalid color");
+
+        return Card(color * FIGURES_IN_COLOR + figure);
+    }
+
+    /**
+     * @brief Gets the index of a figure from the first character of its string representation.
+     * @param c The character, '1' stands for 10.
+     * @return int The index of the figure, -1 if the character does not start a figure.
+     */
+    static constexpr int figure_index(char c)
+    {
+        switch (c)
+        {
+        case '2': case '3': case '4': case '5': case '6': case '7': case '8': case '9':
+            return c - '2';
+        case '1':
+            return 8;
+        case 'J':
+            return 9;
+        case 'Q':
+            return 10;
+        case 'K':
+            return 11;
+        case 'A':
+            return 12;
+        default:
+            return -1;
+        }
+    }
+
+    /**
+     * @brief Gets the index of a color from its letter.
+     * @param c The letter of the color.
+     * @return int The index of the color, -1 if the letter is not a color.
+     */
+    static constexpr int color_index(char c)
+    {
+        switch (c)
+        {
+        case 'C':
+            return 0;
+        case 'D':
+            return 1;
+        case 'H':
+            return 2;
+        case 'S':
+            return 3;
+        default:
+            return -1;
+        }
+    }
+
+    /**
+     * @brief Gets the id of the card.
+     * @return uint8_t The id of the card.
+     */
+    constexpr uint8_t id() const { return card_id; }
+
+    /**
+     * @brief Gets the color of the card.
+     * @return Color The color of the card.
+     */
+    constexpr Color color() const { return COLORS[card_id / FIGURES_IN_COLOR]; }
+
+    /**
+     * @brief Gets the figure of the card.
+     * @return std::string_view The string representation of the figure.
+     */
+    constexpr std::string_view figure() const { return FIGURES[card_id % FIGURES_IN_COLOR]; }
+
+    /**
+     * @brief Gets the rank of the card within its color.
+     * @return int The rank, from 2 for a two to 14 for an ace.
      */
-    Card(const std::string &figure, Color color);
+    constexpr int value() const { return card_id % FIGURES_IN_COLOR + 2; }
 
     /**
      * @brief Compares this card to another card.
      * @param other The other card to compare to.
-     * @return true if this card is considered weaker than the other card, false otherwise.
+     * @return true if this card is ordered before the other card, by color and then by figure, false otherwise.
      */
-    bool operator<(const Card &other) const;
+    constexpr bool operator<(const Card &other) const { return card_id < other.card_id; }
 
     /**
      * @brief Compares this card to another card.
      * @param other The other card to compare to.
-     * @return true if this card is considered stronger than the other card, false otherwise.
+     * @return true if both cards are the same, false otherwise.
      */
-    bool operator==(const Card &other) const;
+    constexpr bool operator==(const Card &other) const { return card_id == other.card_id; }
 
     /**
      * @brief Compares this card to another card, with a special color that is considered stronger.
@@ -183,7 +585,13 @@ public:
      * @param specialColor The color that is considered stronger (trump color).
      * @return true if this card is considered weaker than the other card, false otherwise.
      */
-    bool compare(const Card &other, Color specialColor) const;
+    constexpr bool compare(const Card &other, Color specialColor) const
+    {
+        if (color() == other.color())
+            return card_id < other.card_id;
+
+        return other.color() == specialColor;
+    }
 
     /**
      * @brief Converts the card to a string.
@@ -194,24 +602,59 @@ public:
     /**
      * @brief Parses a string to extract card data.
      *
-     * This method takes a string containing card data and parses it into a vector of Card objects.
+     * This method takes a string containing card data and parses it into a list of at most
+     * MAX_CARDS_IN_LIST Card objects stored in place.
      * Each card in the string should be represented as <figure><color>.
      *
      * @param card_list The string to parse. Expected to contain a list of cards in the format <figure><color>.
-     * @return A vector of Card objects extracted from the string.
+     * @return A list of Card objects extracted from the string.
      */
-    static std::vector<Card> parse_cards(const std::string &card_list);
+    static FixedList<Card, MAX_CARDS_IN_LIST> parse_cards(std::string_view card_list);
 
 private:
-    int value;
+    static constexpr std::string_view FIGURES[FIGURES_IN_COLOR] = {"2", "3", "4", "5", "6", "7", "8", "9", "10", "J", "Q", "K", "A"};
+    static constexpr Color COLORS[4] = {Color::Clubs, Color::Diamonds, Color::Hearts, Color::Spades};
 
-    /**
-     * @brief Validates the figure and color of the card and sets the value.
-     * @throws std::invalid_argument If the figure or color is invalid.
-     */
-    void validate_and_evaluate();
+    uint8_t card_id;
 };
 
+/**
+ * @brief List of at most MAX_CARDS_IN_LIST cards in the order they were given, as in a hand or a trick.
+ */
+using CardList = FixedList<Card, MAX_CARDS_IN_LIST>;
+
+/**
+ * @brief Set of cards, the bit at a card's id is set if the card is in the set.
+ */
+using CardMask = uint64_t;
+
+/**
+ * @brief Gets the mask of a single card.
+ * @param card The card.
+ * @return CardMask The mask with only the card's bit set.
+ */
+constexpr CardMask card_mask(Card card)
+{
+    return CardMask{1} << card.id();
+}
+
+/**
+ * @brief Gets the mask of all cards of a color.
+ * @param color The color.
+ * @return CardMask The mask with the bits of the color's FIGURES_IN_COLOR cards set.
+ */
+constexpr CardMask color_mask(Color color)
+{
+    return ((CardMask{1} << FIGURES_IN_COLOR) - 1) << (Card::color_index(color_letter(color)) * FIGURES_IN_COLOR);
+}
+
+/**
+ * @brief Converts cards to a mask.
+ * @param cards The cards.
+ * @return CardMask The mask with the bits of the cards set.
+ */
+CardMask cards_to_mask(const CardList &cards);
+
 /**
  * @brief Class representing a message.
  */
@@ -219,22 +662,47 @@ class Message
 {
 public:
     MessageType type;
-    std::string data;
+
     /**
-     * @brief Construct a new Message object.
+     * @brief Construct a new Message object, the fields are kept by the derived class.
      *
      * @param type The type of the message.
-     * @param data The data of the message.
      */
-    Message(MessageType type, const std::string &data);
+    explicit Message(MessageType type);
 
     /**
-     * @brief Construct a new Message object.
-     *
-     * @param type The type of the message.
+     * @brief Destroy the Message object.
      */
     virtual ~Message() = default;
 
+    /**
+     * @brief Get the length of the message as sent, \r\n included.
+     *
+     * @return size_t The number of bytes written by serialize_into.
+     */
+    virtual size_t serialized_size() const = 0;
+
+    /**
+     * @brief Write the message as sent, \r\n included.
+     *
+     * @param buffer Space for serialized_size() bytes.
+     */
+    virtual void serialize_into(char *buffer) const = 0;
+
+    /**
+     * @brief Get the length of the message as a binary frame.
+     *
+     * @return size_t The number of bytes written by serialize_binary_into, at most MAX_BINARY_FRAME_SIZE.
+     */
+    virtual size_t binary_size() const = 0;
+
+    /**
+     * @brief Write the message as a binary frame.
+     *
+     * @param buffer Space for binary_size() bytes.
+     */
+    virtual void serialize_binary_into(char *buffer) const = 0;
+
     /**
      * @brief Convert the message to a string.
      *
@@ -243,7 +711,9 @@ public:
     std::string to_string() const;
 
     /**
-     * @brief Create a Message object from a string.
+     * @brief Create a Message object from a string, kept for compatibility.
+     *
+     * Use parse_message to get the message by value.
      *
      * @param str The string to create the Message object from.
      * @return Message The created Message object.
@@ -258,21 +728,43 @@ class IAMMessage : public Message
 {
 public:
     Position position;
+    std::optional<int> table_id;
+    bool binary;
 
     /**
      * @brief Construct a new IAMMessage object.
      *
+     * The table id is an extension of the protocol, it is written in base 10
+     * after the position. Without it the server picks the table. The binary
+     * flag is another extension, written as B at the end, it asks the server
+     * to switch the connection to binary frames after this message.
+     *
      * @param position The position for the IAMMessage.
+     * @param table_id The table the client wants to join.
+     * @param binary Whether the client asks for binary frames.
+     */
+    IAMMessage(Position position, std::optional<int> table_id = std::nullopt, bool binary = false);
+
+    size_t serialized_size() const override;
+    void serialize_into(char *buffer) const override;
+    size_t binary_size() const override;
+    void serialize_binary_into(char *buffer) const override;
+
+    /**
+     * @brief Parse an IAMMessage.
+     *
+     * @param str The message without the terminating \r\n.
+     * @return IAMMessage The parsed message.
      */
-    IAMMessage(Position position);
+    static IAMMessage parse(std::string_view str);
 
     /**
-     * @brief Create an IAMMessage object from a string.
+     * @brief Create an IAMMessage object from a string, kept for compatibility.
      *
-     * @param str The string to create the IAMMessage object from.
+     * @param str The message without the terminating \r\n.
      * @return IAMMessage The created IAMMessage object.
      */
-    static std::shared_ptr<IAMMessage> from_string(const std::string &str);
+    static std::shared_ptr<IAMMessage> from_string(std::string_view str);
 };
 
 /**
@@ -282,21 +774,34 @@ public:
 class BUSYMessage : public Message
 {
 public:
-    std::vector<Position> positions;
+    PositionList positions;
     /**
      * @brief Construct a new BUSYMessage object.
      *
-     * @param positions A vector of positions for the BUSYMessage.
+     * @param positions The busy positions.
      */
-    BUSYMessage(std::vector<Position> positions);
+    BUSYMessage(const PositionList &positions);
+
+    size_t serialized_size() const override;
+    void serialize_into(char *buffer) const override;
+    size_t binary_size() const override;
+    void serialize_binary_into(char *buffer) const override;
 
     /**
-     * @brief Create a BUSYMessage object from a string.
+     * @brief Parse a BUSYMessage.
      *
-     * @param str The string to create the BUSYMessage object from.
+     * @param str The message without the terminating \r\n.
+     * @return BUSYMessage The parsed message.
+     */
+    static BUSYMessage parse(std::string_view str);
+
+    /**
+     * @brief Create a BUSYMessage object from a string, kept for compatibility.
+     *
+     * @param str The message without the terminating \r\n.
      * @return BUSYMessage The created BUSYMessage object.
      */
-    static std::shared_ptr<BUSYMessage> from_string(const std::string &str);
+    static std::shared_ptr<BUSYMessage> from_string(std::string_view str);
 };
 
 /**
@@ -307,7 +812,7 @@ class DEALMessage : public Message
 public:
     DealType type;
     Position first_player;
-    std::vector<Card> cards;
+    CardList cards;
 
     /**
      * @brief Construct a new DEALMessage object.
@@ -316,15 +821,28 @@ public:
      * @param first_player The starting player.
      * @param cards The cards dealt.
      */
-    DEALMessage(DealType type, Position first_player, const std::vector<Card> &cards);
+    DEALMessage(DealType type, Position first_player, const CardList &cards);
+
+    size_t serialized_size() const override;
+    void serialize_into(char *buffer) const override;
+    size_t binary_size() const override;
+    void serialize_binary_into(char *buffer) const override;
+
+    /**
+     * @brief Parse a DEALMessage.
+     *
+     * @param str The message without the terminating \r\n.
+     * @return DEALMessage The parsed message.
+     */
+    static DEALMessage parse(std::string_view str);
 
     /**
-     * @brief Create a DEALMessage object from a string.
+     * @brief Create a DEALMessage object from a string, kept for compatibility.
      *
-     * @param str The string to create the DEALMessage object from.
+     * @param str The message without the terminating \r\n.
      * @return DEALMessage The created DEALMessage object.
      */
-    static std::shared_ptr<DEALMessage> from_string(const std::string &str);
+    static std::shared_ptr<DEALMessage> from_string(std::string_view str);
 };
 
 /**
@@ -334,7 +852,7 @@ class TRICKMessage : public Message
 {
 public:
     int trick_number;
-    std::vector<Card> cards;
+    CardList cards;
 
     /**
      * @brief Construct a new TRICKMessage object.
@@ -342,15 +860,28 @@ public:
      * @param trick_number The number of the trick.
      * @param cards The cards played in the trick.
      */
-    TRICKMessage(int trick_number, const std::vector<Card> &cards);
+    TRICKMessage(int trick_number, const CardList &cards);
+
+    size_t serialized_size() const override;
+    void serialize_into(char *buffer) const override;
+    size_t binary_size() const override;
+    void serialize_binary_into(char *buffer) const override;
 
     /**
-     * @brief Create a TRICKMessage object from a string.
+     * @brief Parse a TRICKMessage.
      *
-     * @param str The string to create the TRICKMessage object from.
+     * @param str The message without the terminating \r\n.
+     * @return TRICKMessage The parsed message.
+     */
+    static TRICKMessage parse(std::string_view str);
+
+    /**
+     * @brief Create a TRICKMessage object from a string, kept for compatibility.
+     *
+     * @param str The message without the terminating \r\n.
      * @return TRICKMessage The created TRICKMessage object.
      */
-    static std::shared_ptr<TRICKMessage> from_string(const std::string &str);
+    static std::shared_ptr<TRICKMessage> from_string(std::string_view str);
 };
 
 /**
@@ -368,13 +899,26 @@ public:
      */
     WRONGMessage(int trick_number);
 
+    size_t serialized_size() const override;
+    void serialize_into(char *buffer) const override;
+    size_t binary_size() const override;
+    void serialize_binary_into(char *buffer) const override;
+
     /**
-     * @brief Create a WRONGMessage object from a string.
+     * @brief Parse a WRONGMessage.
      *
-     * @param str The string to create the WRONGMessage object from.
+     * @param str The message without the terminating \r\n.
+     * @return WRONGMessage The parsed message.
+     */
+    static WRONGMessage parse(std::string_view str);
+
+    /**
+     * @brief Create a WRONGMessage object from a string, kept for compatibility.
+     *
+     * @param str The message without the terminating \r\n.
      * @return WRONGMessage The created WRONGMessage object.
      */
-    static std::shared_ptr<WRONGMessage> from_string(const std::string &str);
+    static std::shared_ptr<WRONGMessage> from_string(std::string_view str);
 };
 
 /**
@@ -385,7 +929,7 @@ class TAKENMessage : public Message
 {
 public:
     int trick_number;
-    std::vector<Card> cards;
+    CardList cards;
     Position taken_by;
 
     /**
@@ -395,15 +939,28 @@ public:
      * @param cards The cards taken in the trick.
      * @param taken_by The player who took the trick.
      */
-    TAKENMessage(int trick_number, const std::vector<Card> &cards, Position taken_by);
+    TAKENMessage(int trick_number, const CardList &cards, Position taken_by);
+
+    size_t serialized_size() const override;
+    void serialize_into(char *buffer) const override;
+    size_t binary_size() const override;
+    void serialize_binary_into(char *buffer) const override;
 
     /**
-     * @brief Create a TAKENMessage object from a string.
+     * @brief Parse a TAKENMessage.
      *
-     * @param str The string to create the TAKENMessage object from.
+     * @param str The message without the terminating \r\n.
+     * @return TAKENMessage The parsed message.
+     */
+    static TAKENMessage parse(std::string_view str);
+
+    /**
+     * @brief Create a TAKENMessage object from a string, kept for compatibility.
+     *
+     * @param str The message without the terminating \r\n.
      * @return TAKENMessage The created TAKENMessage object.
      */
-    static std::shared_ptr<TAKENMessage> from_string(const std::string &str);
+    static std::shared_ptr<TAKENMessage> from_string(std::string_view str);
 };
 
 /**
@@ -412,22 +969,43 @@ public:
 class SCOREMessage : public Message
 {
 public:
-    std::map<Position, int> scores;
+    Scores scores;
 
     /**
      * @brief Construct a new SCOREMessage object.
      *
+     * @param scores The score of every position.
+     */
+    SCOREMessage(const Scores &scores);
+
+    /**
+     * @brief Construct a new SCOREMessage object from a map, kept for compatibility.
+     *
      * @param scores A map of positions to scores.
+     * @throws std::invalid_argument If a position is missing.
      */
     SCOREMessage(const std::map<Position, int> &scores);
 
+    size_t serialized_size() const override;
+    void serialize_into(char *buffer) const override;
+    size_t binary_size() const override;
+    void serialize_binary_into(char *buffer) const override;
+
     /**
-     * @brief Create a SCOREMessage object from a string.
+     * @brief Parse a SCOREMessage.
      *
-     * @param str The string to create the SCOREMessage object from.
+     * @param str The message without the terminating \r\n.
+     * @return SCOREMessage The parsed message.
+     */
+    static SCOREMessage parse(std::string_view str);
+
+    /**
+     * @brief Create a SCOREMessage object from a string, kept for compatibility.
+     *
+     * @param str The message without the terminating \r\n.
      * @return SCOREMessage The created SCOREMessage object.
      */
-    static std::shared_ptr<SCOREMessage> from_string(const std::string &str);
+    static std::shared_ptr<SCOREMessage> from_string(std::string_view str);
 };
 
 /**
@@ -436,22 +1014,104 @@ public:
 class TOTALMessage : public Message
 {
 public:
-    std::map<Position, int> totals;
+    Scores totals;
 
     /**
      * @brief Construct a new TOTALMessage object.
      *
+     * @param totals The total of every position.
+     */
+    TOTALMessage(const Scores &totals);
+
+    /**
+     * @brief Construct a new TOTALMessage object from a map, kept for compatibility.
+     *
      * @param totals A map of positions to totals.
+     * @throws std::invalid_argument If a position is missing.
      */
     TOTALMessage(const std::map<Position, int> &totals);
 
+    size_t serialized_size() const override;
+    void serialize_into(char *buffer) const override;
+    size_t binary_size() const override;
+    void serialize_binary_into(char *buffer) const override;
+
+    /**
+     * @brief Parse a TOTALMessage.
+     *
+     * @param str The message without the terminating \r\n.
+     * @return TOTALMessage The parsed message.
+     */
+    static TOTALMessage parse(std::string_view str);
+
     /**
-     * @brief Create a TOTALMessage object from a string.
+     * @brief Create a TOTALMessage object from a string, kept for compatibility.
      *
-     * @param str The string to create the TOTALMessage object from.
+     * @param str The message without the terminating \r\n.
      * @return TOTALMessage The created TOTALMessage object.
      */
-    static std::shared_ptr<TOTALMessage> from_string(const std::string &str);
+    static std::shared_ptr<TOTALMessage> from_string(std::string_view str);
+};
+
+/**
+ * @brief Any message, held by value and dispatched with std::visit.
+ */
+using AnyMessage = std::variant<IAMMessage, BUSYMessage, DEALMessage, TRICKMessage, WRONGMessage, TAKENMessage, SCOREMessage, TOTALMessage>;
+
+/**
+ * @brief Visitor made of lambdas, each of them handles some of the alternatives.
+ * @tparam Ts The types of the lambdas.
+ */
+template <typename... Ts>
+struct Overloaded : Ts...
+{
+    using Ts::operator()...;
 };
 
+template <typename... Ts>
+Overloaded(Ts...) -> Overloaded<Ts...>;
+
+/**
+ * @brief Check if a message is a binary frame.
+ *
+ * A binary frame starts with its length in bytes, the type of the message
+ * and the fields in binary: positions as their letters, deal types and
+ * trick numbers as single bytes, cards as their ids and scores as 32-bit
+ * big-endian numbers. Text messages start with a letter, so the first byte
+ * tells the formats apart.
+ *
+ * @param first The first byte of the message.
+ * @return true if the message is a binary frame, false otherwise.
+ */
+constexpr bool is_binary_frame(char first)
+{
+    return static_cast<unsigned char>(first) <= MAX_BINARY_FRAME_SIZE;
+}
+
+/**
+ * @brief Check if a binary frame of this length can hold any message.
+ *
+ * Frames are 2 to 8 bytes long (BUSY, IAM, TRICK, WRONG, TAKEN), 17 bytes
+ * (DEAL) or 18 bytes (SCORE, TOTAL). Other lengths, among them the line
+ * end bytes, start no frame.
+ *
+ * @param first The first byte of the frame, its length.
+ * @return true if some message has a frame of this length, false otherwise.
+ */
+constexpr bool is_binary_frame_length(char first)
+{
+    unsigned char length = static_cast<unsigned char>(first);
+    return (length >= 2 && length <= 8) || length == 17 || length == 18;
+}
+
+/**
+ * @brief Parse a message in the wire format of the connection.
+ *
+ * @param str The message with the terminating \r\n, or a binary frame.
+ * @param binary Whether the connection has switched to binary frames, text messages are rejected then and frames otherwise.
+ * @return AnyMessage The parsed message.
+ * @throws std::invalid_argument If the message is malformed or not in the format of the connection.
+ */
+AnyMessage parse_message(std::string_view str, bool binary = false);
+
 #endif // COMMON_H
\ No newline at end of file
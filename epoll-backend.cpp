@@ -0,0 +1,152 @@
+#include "epoll-backend.h"
+
+EpollBackend::EpollBackend()
+{
+    listener = nullptr;
+    accept_resume_time = -1;
+    inbox_fd = -1;
+}
+
+void EpollBackend::add_listener(Socket &listener)
+{
+    this->listener = &listener;
+    event_loop.add(listener.socket_fd, EPOLLIN);
+}
+
+void EpollBackend::add_inbox(int inbox_fd)
+{
+    this->inbox_fd = inbox_fd;
+    event_loop.add(inbox_fd, EPOLLIN);
+}
+
+void EpollBackend::add_client(const std::shared_ptr<Socket> &socket)
+{
+    event_loop.add(socket->socket_fd, CLIENT_EVENTS);
+    clients[socket->socket_fd] = EpollClient{socket, false, false, false};
+}
+
+void EpollBackend::remove_client(const std::shared_ptr<Socket> &socket)
+{
+    event_loop.remove(socket->socket_fd);
+    clients.erase(socket->socket_fd);
+}
+
+void EpollBackend::flush_client(const std::shared_ptr<Socket> &socket)
+{
+    auto it = clients.find(socket->socket_fd);
+    if (it == clients.end())
+        return;
+
+    // Output is written right away, write interest is armed only if the socket could not take all of it.
+    socket->handle_write();
+    update_write_interest(it->second);
+}
+
+void EpollBackend::throttle_client(const std::shared_ptr<Socket> &socket, bool throttled)
+{
+    auto it = clients.find(socket->socket_fd);
+    if (it == clients.end())
+        return;
+
+    EpollClient &client = it->second;
+    client.throttled = throttled;
+
+    // The edge was consumed while throttled, so the socket is read right away.
+    if (!throttled && client.unread)
+    {
+        client.unread = false;
+        socket->handle_read();
+    }
+}
+
+int EpollBackend::wait(int timeout)
+{
+    events.clear();
+
+    if (accept_resume_time >= 0)
+    {
+        if (get_monotonic_time_in_millis() >= accept_resume_time)
+        {
+            event_loop.add(listener->socket_fd, EPOLLIN);
+            accept_resume_time = -1;
+        }
+        else
+            timeout = timeout_until(timeout, accept_resume_time);
+    }
+
+    int events_count = event_loop.wait(timeout);
+    for (int i = 0; i < events_count; i++)
+    {
+        const epoll_event &event = event_loop.event(i);
+
+        if (listener != nullptr && event.data.fd == listener->socket_fd)
+        {
+            bool back_off;
+            std::shared_ptr<Socket> socket = listener->accept_connection(back_off);
+            if (socket != nullptr)
+                events.push_back(IOEvent{IOEventType::Accept, socket, false});
+            else if (back_off)
+            {
+                event_loop.remove(listener->socket_fd);
+                accept_resume_time = get_monotonic_time_in_millis() + ACCEPT_BACKOFF_MS;
+            }
+        }
+        else if (event.data.fd == inbox_fd)
+        {
+            events.push_back(IOEvent{IOEventType::Inbox, nullptr, false});
+        }
+        else
+        {
+            auto it = clients.find(event.data.fd);
+            if (it != clients.end())
+                handle_client(it->second, event.events);
+        }
+    }
+
+    return events.size();
+}
+
+const IOEvent &EpollBackend::event(int idx) const
+{
+    return events[idx];
+}
+
+/*
+ * Private functions
+ */
+
+void EpollBackend::handle_client(EpollClient &client, uint32_t ready)
+{
+    std::shared_ptr<Socket> socket = client.socket;
+    bool hangup = false;
+
+    if (ready & EPOLLIN)
+    {
+        if (client.throttled)
+            client.unread = true;
+        else
+            socket->handle_read();
+    }
+
+    if (ready & (EPOLLRDHUP | EPOLLHUP | EPOLLERR))
+    {
+        socket->handle_read();
+        socket->closed = true;
+        hangup = true;
+    }
+
+    if (ready & EPOLLOUT)
+        socket->handle_write();
+
+    events.push_back(IOEvent{IOEventType::Client, socket, hangup});
+}
+
+void EpollBackend::update_write_interest(EpollClient &client)
+{
+    bool pending_output = client.socket->has_pending_output();
+    if (pending_output == client.write_armed)
+        return;
+
+    event_loop.modify(client.socket->socket_fd, pending_output ? CLIENT_EVENTS | EPOLLOUT : CLIENT_EVENTS);
+    client.write_armed = pending_output;
+}
\ No newline at end of file
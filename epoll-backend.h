@@ -0,0 +1,74 @@
+#ifndef EPOLL_BACKEND_H
+#define EPOLL_BACKEND_H
+
+#include <unordered_map>
+#include <vector>
+
+#include "event-loop.h"
+#include "io-backend.h"
+
+#define CLIENT_EVENTS (EPOLLIN | EPOLLRDHUP | EPOLLET)
+
+/**
+ * @brief Client connection registered in the event loop
+ */
+struct EpollClient
+{
+    std::shared_ptr<Socket> socket;
+    bool write_armed;
+    bool throttled;
+    bool unread;
+};
+
+/**
+ * @brief I/O backend based on epoll readiness
+ *
+ * Client sockets are edge-triggered and read until they would block, output
+ * is written right away and write interest is armed only while some of it
+ * is left over. A throttled socket is not read, the edges it gets meanwhile
+ * are remembered. The listening socket is left out for a while when
+ * descriptors run out, a pending connection would wake it up right away.
+ */
+class EpollBackend : public IOBackend
+{
+private:
+    EventLoop event_loop;
+    Socket *listener;
+    long long accept_resume_time;
+    int inbox_fd;
+    std::unordered_map<int, EpollClient> clients;
+    std::vector<IOEvent> events;
+
+public:
+    /**
+     * @brief Construct a new EpollBackend object
+     */
+    EpollBackend();
+
+    void add_listener(Socket &listener) override;
+    void add_inbox(int inbox_fd) override;
+    void add_client(const std::shared_ptr<Socket> &socket) override;
+    void remove_client(const std::shared_ptr<Socket> &socket) override;
+    void flush_client(const std::shared_ptr<Socket> &socket) override;
+    void throttle_client(const std::shared_ptr<Socket> &socket, bool throttled) override;
+    int wait(int timeout) override;
+    const IOEvent &event(int idx) const override;
+
+private:
+    /**
+     * @brief Do I/O of a client socket that has become ready
+     *
+     * @param client Client
+     * @param ready Ready events
+     */
+    void handle_client(EpollClient &client, uint32_t ready);
+
+    /**
+     * @brief Arm write interest if the client has pending output, disarm it otherwise
+     *
+     * @param client Client
+     */
+    void update_write_interest(EpollClient &client);
+};
+
+#endif // EPOLL_BACKEND_H
\ No newline at end of file
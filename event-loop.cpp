@@ -0,0 +1,65 @@
+#include <unistd.h>
+#include <string.h>
+#include <stdexcept>
+
+#include "event-loop.h"
+
+EventLoop::EventLoop(int max_events)
+{
+    epoll_fd = epoll_create1(EPOLL_CLOEXEC);
+    if (epoll_fd == -1)
+        throw std::runtime_error(strerror(errno));
+
+    events.resize(max_events);
+}
+
+EventLoop::~EventLoop()
+{
+    close(epoll_fd);
+}
+
+void EventLoop::add(int fd, uint32_t events)
+{
+    epoll_event event;
+    memset(&event, 0, sizeof(event));
+    event.events = events;
+    event.data.fd = fd;
+
+    if (epoll_ctl(epoll_fd, EPOLL_CTL_ADD, fd, &event) == -1)
+        throw std::runtime_error(strerror(errno));
+}
+
+void EventLoop::modify(int fd, uint32_t events)
+{
+    epoll_event event;
+    memset(&event, 0, sizeof(event));
+    event.events = events;
+    event.data.fd = fd;
+
+    if (epoll_ctl(epoll_fd, EPOLL_CTL_MOD, fd, &event) == -1)
+        throw std::runtime_error(strerror(errno));
+}
+
+void EventLoop::remove(int fd)
+{
+    if (epoll_ctl(epoll_fd, EPOLL_CTL_DEL, fd, nullptr) == -1)
+        throw std::runtime_error(strerror(errno));
+}
+
+int EventLoop::wait(int timeout)
+{
+    int events_count = epoll_wait(epoll_fd, events.data(), events.size(), timeout);
+    if (events_count == -1)
+    {
+        if (errno == EINTR)
+            return 0;
+        throw std::runtime_error(strerror(errno));
+    }
+
+    return events_count;
+}
+
+const epoll_event &EventLoop::event(int idx) const
+{
+    return events[idx];
+}
\ No newline at end of file
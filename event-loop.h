@@ -0,0 +1,78 @@
+#ifndef EVENT_LOOP_H
+#define EVENT_LOOP_H
+
+#include <cstdint>
+#include <vector>
+#include <sys/epoll.h>
+
+#define MAX_EVENTS 256
+
+/**
+ * @brief Event loop based on epoll
+ *
+ * File descriptors are registered once and stay registered until removed,
+ * so a wakeup only reports the descriptors that actually have events.
+ */
+class EventLoop
+{
+private:
+    int epoll_fd;
+    std::vector<epoll_event> events;
+
+public:
+    /**
+     * @brief Construct a new EventLoop object
+     *
+     * @param max_events Maximum number of events reported by a single wait
+     */
+    EventLoop(int max_events = MAX_EVENTS);
+
+    /**
+     * @brief Destroy the EventLoop object
+     */
+    ~EventLoop();
+
+    EventLoop(const EventLoop &) = delete;
+    EventLoop &operator=(const EventLoop &) = delete;
+
+    /**
+     * @brief Register file descriptor
+     *
+     * @param fd File descriptor
+     * @param events Events to listen for (EPOLLIN, EPOLLOUT, EPOLLET, ...)
+     */
+    void add(int fd, uint32_t events);
+
+    /**
+     * @brief Change events of a registered file descriptor
+     *
+     * @param fd File descriptor
+     * @param events Events to listen for
+     */
+    void modify(int fd, uint32_t events);
+
+    /**
+     * @brief Unregister file descriptor
+     *
+     * @param fd File descriptor
+     */
+    void remove(int fd);
+
+    /**
+     * @brief Wait for events
+     *
+     * @param timeout Timeout in milliseconds, -1 waits indefinitely
+     * @return Number of ready events, accessible with event()
+     */
+    int wait(int timeout);
+
+    /**
+     * @brief Get event reported by the last wait
+     *
+     * @param idx Index of the event
+     * @return Event
+     */
+    const epoll_event &event(int idx) const;
+};
+
+#endif // EVENT_LOOP_H
\ No newline at end of file
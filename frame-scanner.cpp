@@ -0,0 +1,54 @@
+#include <cstdint>
+
+#if defined(__AVX2__) || defined(__SSE2__)
+#include <immintrin.h>
+#endif
+
+#include "frame-scanner.h"
+
+/**
+ * @brief Append the ends of the lines whose newlines are marked in a mask
+ *
+ * @param mask Bit i is set if byte i is a newline
+ * @param base Offset of byte 0
+ * @param ends Offsets just past every newline
+ */
+static void append_masked_ends(uint32_t mask, size_t base, std::vector<size_t> &ends)
+{
+    while (mask != 0)
+    {
+        ends.push_back(base + __builtin_ctz(mask) + 1);
+        mask &= mask - 1;
+    }
+}
+
+void find_line_ends(const char *bytes, size_t length, size_t base, std::vector<size_t> &ends)
+{
+    size_t i = 0;
+
+#ifdef __AVX2__
+    const __m256i newlines32 = _mm256_set1_epi8('\n');
+    for (; i + 32 <= length; i += 32)
+    {
+        __m256i block = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(bytes + i));
+        uint32_t mask = _mm256_movemask_epi8(_mm256_cmpeq_epi8(block, newlines32));
+        append_masked_ends(mask, base + i, ends);
+    }
+#endif
+
+#ifdef __SSE2__
+    const __m128i newlines16 = _mm_set1_epi8('\n');
+    for (; i + 16 <= length; i += 16)
+    {
+        __m128i block = _mm_loadu_si128(reinterpret_cast<const __m128i *>(bytes + i));
+        uint32_t mask = _mm_movemask_epi8(_mm_cmpeq_epi8(block, newlines16));
+        append_masked_ends(mask, base + i, ends);
+    }
+#endif
+
+    for (; i < length; i++)
+    {
+        if (bytes[i] == '\n')
+            ends.push_back(base + i + 1);
+    }
+}
\ No newline at end of file
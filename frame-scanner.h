@@ -0,0 +1,22 @@
+#ifndef FRAME_SCANNER_H
+#define FRAME_SCANNER_H
+
+#include <cstddef>
+#include <vector>
+
+/**
+ * @brief Find the ends of all lines in a block of bytes in one pass
+ *
+ * Bytes are compared 32 at a time with AVX2 or 16 at a time with SSE2,
+ * whichever the build targets, and one at a time on other architectures
+ * and for the bytes left over. The newlines of a whole receive buffer are
+ * found by one call instead of one search per message.
+ *
+ * @param bytes Bytes
+ * @param length Number of bytes
+ * @param base Offset of the first byte, added to every found end
+ * @param ends Offsets just past every newline, appended in order
+ */
+void find_line_ends(const char *bytes, size_t length, size_t base, std::vector<size_t> &ends);
+
+#endif // FRAME_SCANNER_H
\ No newline at end of file
@@ -0,0 +1,31 @@
+#include <algorithm>
+#include <iostream>
+#include <stdexcept>
+
+#include "epoll-backend.h"
+#include "uring-backend.h"
+
+std::unique_ptr<IOBackend> IOBackend::create(BackendType type)
+{
+    if (type == BackendType::Uring)
+    {
+        try
+        {
+            return std::make_unique<UringBackend>();
+        }
+        catch (const std::runtime_error &e)
+        {
+            std::cerr << "io_uring not available (" << e.what() << "), falling back to epoll\n";
+        }
+    }
+
+    return std::make_unique<EpollBackend>();
+}
+
+int IOBackend::timeout_until(int timeout, long long deadline)
+{
+    long long remaining = std::max(0LL, deadline - get_monotonic_time_in_millis());
+    if (timeout < 0 || timeout > remaining)
+        return remaining;
+    return timeout;
+}
\ No newline at end of file
@@ -0,0 +1,133 @@
+#ifndef IO_BACKEND_H
+#define IO_BACKEND_H
+
+#include <memory>
+
+#include "network-common.h"
+
+/**
+ * @brief I/O backend type
+ */
+enum class BackendType
+{
+    Epoll,
+    Uring,
+};
+
+/**
+ * @brief I/O event type
+ */
+enum class IOEventType
+{
+    Accept,
+    Inbox,
+    Client,
+};
+
+/**
+ * @brief Event reported by an I/O backend
+ *
+ * The backend has already done the I/O: an accepted connection is wrapped in
+ * a socket, received bytes are in the socket's reading queue and sent bytes
+ * are gone from its writing queue.
+ */
+struct IOEvent
+{
+    IOEventType type;
+    std::shared_ptr<Socket> socket;
+    bool hangup;
+};
+
+/**
+ * @brief I/O backend of a server shard
+ *
+ * Backends differ only in how they move bytes between the kernel and the
+ * sockets' queues, game logic sees the same events from all of them.
+ */
+class IOBackend
+{
+public:
+    virtual ~IOBackend() = default;
+
+    /**
+     * @brief Create backend, fall back to epoll if the requested one is not supported
+     *
+     * @param type Backend type
+     * @return Backend
+     */
+    static std::unique_ptr<IOBackend> create(BackendType type);
+
+    /**
+     * @brief Accept connections on the listening socket
+     *
+     * @param listener Listening socket, must outlive the backend
+     */
+    virtual void add_listener(Socket &listener) = 0;
+
+    /**
+     * @brief Report when the inbox eventfd is signalled
+     *
+     * @param inbox_fd Inbox eventfd
+     */
+    virtual void add_inbox(int inbox_fd) = 0;
+
+    /**
+     * @brief Start doing I/O of a client
+     *
+     * @param socket Socket
+     */
+    virtual void add_client(const std::shared_ptr<Socket> &socket) = 0;
+
+    /**
+     * @brief Stop doing I/O of a client, the socket may be passed to another shard afterwards
+     *
+     * @param socket Socket
+     */
+    virtual void remove_client(const std::shared_ptr<Socket> &socket) = 0;
+
+    /**
+     * @brief Start writing output queued on a client and keep receiving from it
+     *
+     * @param socket Socket
+     */
+    virtual void flush_client(const std::shared_ptr<Socket> &socket) = 0;
+
+    /**
+     * @brief Stop or resume receiving from a client, the peer of a throttled client is held back by TCP flow control
+     *
+     * Bytes received before the client was throttled may still be reported,
+     * bytes received on resuming are left to the caller.
+     *
+     * @param socket Socket
+     * @param throttled Whether to stop receiving
+     */
+    virtual void throttle_client(const std::shared_ptr<Socket> &socket, bool throttled) = 0;
+
+    /**
+     * @brief Wait for events
+     *
+     * @param timeout Timeout in milliseconds, -1 means no timeout
+     * @return Number of events
+     */
+    virtual int wait(int timeout) = 0;
+
+    /**
+     * @brief Get event reported by the last wait
+     *
+     * @param idx Index of the event
+     * @return Event
+     */
+    virtual const IOEvent &event(int idx) const = 0;
+
+protected:
+    /**
+     * @brief Shorten a wait timeout so that it ends by a deadline
+     *
+     * @param timeout Timeout in milliseconds, -1 means no timeout
+     * @param deadline Deadline on the monotonic clock in milliseconds
+     * @return Timeout in milliseconds, 0 if the deadline has passed
+     */
+    static int timeout_until(int timeout, long long deadline);
+};
+
+#endif // IO_BACKEND_H
\ No newline at end of file
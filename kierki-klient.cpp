@@ -1,5 +1,6 @@
 #include <iostream>
 #include <unistd.h>
+#include <getopt.h>
 #include <stdlib.h>
 #include <poll.h>
 #include <cstring>
@@ -13,7 +14,10 @@ struct Args
     uint16_t port;
     IPVersion ip_version;
     Position position;
+    std::optional<int> table_id;
     bool automatic;
+    bool stats;
+    bool binary;
 };
 
 Args parse_args(int argc, char *argv[])
@@ -27,8 +31,15 @@ Args parse_args(int argc, char *argv[])
     args.ip_version = IPVersion::Unspecified;
     args.position = Position::North;
     args.automatic = false;
+    args.stats = false;
+    args.binary = false;
 
-    while ((opt = getopt(argc, argv, "h:p:46NESWa")) != -1)
+    static const option long_options[] = {
+        {"stats", no_argument, nullptr, 's'},
+        {"binary", no_argument, nullptr, 'b'},
+        {nullptr, 0, nullptr, 0}};
+
+    while ((opt = getopt_long(argc, argv, "h:p:46NESWaT:", long_options, nullptr)) != -1)
     {
         switch (opt)
         {
@@ -63,98 +74,97 @@ Args parse_args(int argc, char *argv[])
         case 'a':
             args.automatic = true;
             break;
+        case 'T':
+            args.table_id = std::atoi(optarg);
+            break;
+        case 's':
+            args.stats = true;
+            break;
+        case 'b':
+            args.binary = true;
+            break;
         default:
 
-            throw std::runtime_error("Usage: " + std::string(argv[0]) + " -h <host> -p <port> [-4|-6] [-N|-E|-S|-W] [-a]");
+            throw std::runtime_error("Usage: " + std::string(argv[0]) + " -h <host> -p <port> [-4|-6] [-N|-E|-S|-W] [-T <table>] [-a] [--stats] [--binary]");
         }
     }
 
     if (port != nullptr)
         args.port = read_port(port);
 
-    if (args.host == nullptr || args.port == 0 || !position_set)
-        throw std::runtime_error("Usage: " + std::string(argv[0]) + " -h <host> -p <port> [-4|-6] [-N|-E|-S|-W] [-a]");
+    if (args.host == nullptr || args.port == 0 || !position_set || (args.table_id.has_value() && args.table_id.value() < 0))
+        throw std::runtime_error("Usage: " + std::string(argv[0]) + " -h <host> -p <port> [-4|-6] [-N|-E|-S|-W] [-T <table>] [-a] [--stats] [--binary]");
 
     return args;
 }
 
-void handle_messages(Args args, Socket &socket, ClientGameState &client_game_state)
+int handle_messages(Args args, Socket &socket, ClientGameState &client_game_state)
 {
+    int handled = 0;
+
     while (true)
     {
-        std::string message_str = socket.extract_message();
+        std::string_view message_str = socket.next_message();
         if (message_str.empty())
-            return;
+            return handled;
+
+        handled++;
 
         try
         {
-            std::shared_ptr<Message> message_ptr = Message::from_string(message_str);
+            AnyMessage message = parse_message(message_str, socket.binary);
 
-            if (message_ptr->type == MessageType::DEAL)
-            {
-                DEALMessage deal_message = dynamic_cast<DEALMessage &>(*message_ptr);
-                client_game_state.new_deal(deal_message);
-            }
-            else if (message_ptr->type == MessageType::BUSY)
-            {
-                BUSYMessage busy_message = dynamic_cast<BUSYMessage &>(*message_ptr);
-                if (!args.automatic)
+            std::visit(Overloaded{
+                [&](const DEALMessage &deal_message) { client_game_state.new_deal(deal_message); },
+                [&](const BUSYMessage &busy_message)
                 {
-                    std::cout << "Place busy, list of busy places received: ";
-
-                    if (!busy_message.positions.empty())
+                    if (!args.automatic)
                     {
-                        auto it = busy_message.positions.begin();
-                        std::cout << ::to_string<Position>(*it);
-                        ++it;
-                        for (; it != busy_message.positions.end(); ++it)
+                        std::cout << "Place busy, list of busy places received: ";
+
+                        if (!busy_message.positions.empty())
                         {
-                            std::cout << ", " << ::to_string<Position>(*it);
+                            auto it = busy_message.positions.begin();
+                            std::cout << position_letter(*it);
+                            ++it;
+                            for (; it != busy_message.positions.end(); ++it)
+                            {
+                                std::cout << ", " << position_letter(*it);
+                            }
                         }
+                        std::cout << ".\n";
                     }
-                    std::cout << ".\n";
-                }
-                throw std::runtime_error("Place busy");
-            }
-            else if (message_ptr->type == MessageType::TRICK)
-            {
-                TRICKMessage trick_message = dynamic_cast<TRICKMessage &>(*message_ptr);
-                client_game_state.new_trick(trick_message);
+                    throw std::runtime_error("Place busy");
+                },
+                [&](const TRICKMessage &trick_message)
+                {
+                    client_game_state.new_trick(trick_message);
 
-                if (args.automatic && client_game_state.waiting_for_move)
+                    if (args.automatic && client_game_state.waiting_for_move)
+                    {
+                        Card card = client_game_state.get_best_move();
+                        TRICKMessage response(client_game_state.trick, CardList{card});
+                        socket.send(response);
+                        client_game_state.waiting_for_move = false;
+                    }
+                },
+                [&](const WRONGMessage &wrong_message)
                 {
-                    Card card = client_game_state.get_best_move();
-                    TRICKMessage response(client_game_state.trick, std::vector<Card>{card});
-                    socket.send(response.to_string());
-                    client_game_state.waiting_for_move = false;
-                }
-            }
-            else if (message_ptr->type == MessageType::WRONG)
-            {
-                WRONGMessage wrong_message = dynamic_cast<WRONGMessage &>(*message_ptr);
-                if (!args.automatic)
-                    std::cout << "Wrong message received in trick " << wrong_message.trick_number << ".\n";
-            }
-            else if (message_ptr->type == MessageType::TAKEN)
-            {
-                TAKENMessage taken_message = dynamic_cast<TAKENMessage &>(*message_ptr);
-                client_game_state.end_trick(taken_message);
-            }
-            else if (message_ptr->type == MessageType::SCORE)
-            {
-                SCOREMessage score_message = dynamic_cast<SCOREMessage &>(*message_ptr);
-                client_game_state.get_score(score_message);
-            }
-            else if (message_ptr->type == MessageType::TOTAL)
-            {
-                TOTALMessage total_message = dynamic_cast<TOTALMessage &>(*message_ptr);
-                client_game_state.get_total(total_message);
-            }
+                    if (!args.automatic)
+                        std::cout << "Wrong message received in trick " << wrong_message.trick_number << ".\n";
+                },
+                [&](const TAKENMessage &taken_message) { client_game_state.end_trick(taken_message); },
+                [&](const SCOREMessage &score_message) { client_game_state.get_score(score_message); },
+                [&](const TOTALMessage &total_message) { client_game_state.get_total(total_message); },
+                [](const IAMMessage &) {},
+            }, message);
         }
         catch (std::invalid_argument &e)
         {
             std::cerr << e.what() << '\n';
         }
+
+        socket.release_message();
     }
 }
 
@@ -176,8 +186,8 @@ void handle_user_input(Socket &socket, ClientGameState &client_game_state)
             Card card(input.substr(1));
             if (client_game_state.waiting_for_move && client_game_state.is_valid_move(card))
             {
-                TRICKMessage trick_message(client_game_state.trick, std::vector<Card>{card});
-                socket.send(trick_message.to_string());
+                TRICKMessage trick_message(client_game_state.trick, CardList{card});
+                socket.send(trick_message);
                 client_game_state.waiting_for_move = false;
             }
             else
@@ -198,13 +208,16 @@ void run_client(Args args)
     Socket socket(args.host, args.port, args.ip_version, args.automatic);
     ClientGameState client_game_state(args.position, !args.automatic);
 
-    IAMMessage iam_message(args.position);
-    socket.send(iam_message.to_string());
+    // The IAM is sent as text, the connection switches to binary frames right after it.
+    IAMMessage iam_message(args.position, args.table_id, args.binary);
+    socket.send(iam_message);
+    socket.binary = args.binary;
+
+    LoopStats loop_stats(args.stats, "client");
 
     struct pollfd fds[2];
 
     fds[0].fd = socket.socket_fd;
-    fds[0].events = POLLIN | POLLOUT | POLLHUP;
     int n = 1;
 
     if (!args.automatic)
@@ -214,14 +227,21 @@ void run_client(Args args)
         n = 2;
     }
 
-    handle_messages(args, socket, client_game_state);
+    loop_stats.handled(handle_messages(args, socket, client_game_state));
 
     while (!socket.closed || !socket.all_messages_received)
     {
+        // Writability is requested only for queued output, otherwise the loop sleeps until the server or user acts.
+        fds[0].events = POLLIN | POLLHUP;
+        if (socket.has_pending_output())
+            fds[0].events |= POLLOUT;
+
         int ret = poll(fds, n, -1);
         if (ret == -1)
             throw std::runtime_error(strerror(errno));
 
+        loop_stats.wakeup();
+
         if (fds[0].revents & POLLIN)
             socket.handle_read();
 
@@ -234,7 +254,8 @@ void run_client(Args args)
         if (!args.automatic && fds[1].revents & POLLIN)
             handle_user_input(socket, client_game_state);
 
-        handle_messages(args, socket, client_game_state);
+        loop_stats.handled(handle_messages(args, socket, client_game_state));
+        loop_stats.queued(socket.pending_output_bytes());
     }
 
     if (!client_game_state.deal_ended)
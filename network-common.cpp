@@ -5,8 +5,8 @@
 #include <fcntl.h>
 #include <string.h>
 #include <stdexcept>
-#include <deque>
 #include <memory>
+#include <algorithm>
 #include <netinet/in.h>
 #include <arpa/inet.h>
 #include <iostream>
@@ -71,6 +71,42 @@ static struct addrinfo *get_local_addr_info(int sockfd)
     return res;
 }
 
+static void log_message(const std::string &from_ip, uint16_t from_port, const std::string &to_ip, uint16_t to_port, std::string_view message)
+{
+    // Binary frames are logged as the text messages they stand for.
+    std::string text;
+    if (!message.empty() && is_binary_frame(message[0]))
+    {
+        try
+        {
+            AnyMessage decoded = parse_message(message, true);
+            text = std::visit([](const auto &alternative) { return alternative.to_string(); }, decoded);
+        }
+        catch (const std::invalid_argument &)
+        {
+            text = "<invalid binary frame>\r\n";
+        }
+        message = text;
+    }
+
+    // The line is written at once, so logs of sockets handled by different threads do not interleave.
+    std::stringstream line;
+    line << '['
+         << from_ip
+         << ':'
+         << from_port
+         << ','
+         << to_ip
+         << ':'
+         << to_port
+         << ','
+         << current_time_to_string()
+         << "] "
+         << message;
+
+    std::cout << line.str();
+}
+
 uint16_t read_port(const char *port)
 {
     char *end;
@@ -87,11 +123,18 @@ long long get_current_time_in_millis()
     return duration_ms;
 }
 
+long long get_monotonic_time_in_millis()
+{
+    auto epoch = std::chrono::steady_clock::now().time_since_epoch();
+    return std::chrono::duration_cast<std::chrono::milliseconds>(epoch).count();
+}
+
 std::string current_time_to_string()
 {
     auto now = std::chrono::system_clock::now();
     auto itt = std::chrono::system_clock::to_time_t(now);
-    std::tm bt = *std::localtime(&itt);
+    std::tm bt;
+    localtime_r(&itt, &bt);
 
     auto duration_ms = get_current_time_in_millis();
     auto ms = duration_ms % 1000;
@@ -103,6 +146,83 @@ std::string current_time_to_string()
     return ss.str();
 }
 
+LoopStats::LoopStats(bool enabled, const std::string &name)
+{
+    this->enabled = enabled;
+    this->name = name;
+    wakeups = 0;
+    messages = 0;
+    peak_output = 0;
+    slow_clients = 0;
+    interval_start = get_monotonic_time_in_millis();
+}
+
+void LoopStats::wakeup()
+{
+    if (!enabled)
+        return;
+
+    wakeups++;
+
+    long long now = get_monotonic_time_in_millis();
+    long long elapsed = now - interval_start;
+    if (elapsed < STATS_INTERVAL)
+        return;
+
+    std::stringstream report;
+    report << '[' << name << "] "
+           << wakeups << " wakeups, "
+           << messages << " messages, "
+           << peak_output << " bytes peak output, "
+           << slow_clients << " slow clients in "
+           << std::fixed << std::setprecision(1) << elapsed / 1000.0 << " s ("
+           << wakeups * 1000.0 / elapsed << " wakeups/s)\n";
+
+    std::cerr << report.str();
+
+    wakeups = 0;
+    messages = 0;
+    peak_output = 0;
+    slow_clients = 0;
+    interval_start = now;
+}
+
+void LoopStats::handled(int count)
+{
+    messages += count;
+}
+
+void LoopStats::queued(size_t bytes)
+{
+    peak_output = std::max(peak_output, bytes);
+}
+
+void LoopStats::slow_client()
+{
+    slow_clients++;
+}
+
+SharedMessage::SharedMessage(const AnyMessage &message) : message(message)
+{
+}
+
+const SharedBuffer &SharedMessage::buffer(bool binary)
+{
+    SharedBuffer &buffer = binary ? this->binary : text;
+    if (buffer == nullptr)
+    {
+        const Message &base = std::visit([](const auto &alternative) -> const Message & { return alternative; }, message);
+        std::string bytes(binary ? base.binary_size() : base.serialized_size(), '\0');
+        if (binary)
+            base.serialize_binary_into(bytes.data());
+        else
+            base.serialize_into(bytes.data());
+        buffer = std::make_shared<const std::string>(std::move(bytes));
+    }
+
+    return buffer;
+}
+
 Socket::Socket(const char *host, uint16_t port, IPVersion ip_version, bool verbose)
 {
     struct addrinfo hints, *res;
@@ -129,8 +249,14 @@ Socket::Socket(const char *host, uint16_t port, IPVersion ip_version, bool verbo
 
     this->verbose = verbose;
     closed = false;
-    all_messages_received = false;
+    all_messages_sent = false;
     all_messages_received = true;
+    binary = false;
+    output_bytes = 0;
+    read_offset = 0;
+    scanned = 0;
+    next_line_end = 0;
+    unreleased = 0;
 
     struct addrinfo *p;
     for (p = res; p != NULL; p = p->ai_next)
@@ -158,19 +284,23 @@ Socket::Socket(const char *host, uint16_t port, IPVersion ip_version, bool verbo
 
     freeaddrinfo(res);
 
-    read_queue = std::deque<char>();
-    write_queue = std::deque<char>();
 
     if (fcntl(socket_fd, F_SETFL, O_NONBLOCK) == -1)
         throw std::runtime_error(strerror(errno));
 }
 
-Socket::Socket(uint16_t port, bool verbose)
+Socket::Socket(uint16_t port, bool verbose, bool reuse_port)
 {
     this->verbose = verbose;
     closed = false;
     all_messages_received = false;
     all_messages_sent = false;
+    binary = false;
+    output_bytes = 0;
+    read_offset = 0;
+    scanned = 0;
+    next_line_end = 0;
+    unreleased = 0;
 
     struct addrinfo hints, *res, *p;
 
@@ -199,6 +329,16 @@ Socket::Socket(uint16_t port, bool verbose)
             }
         }
 
+        if (reuse_port)
+        {
+            int on = 1;
+            if (setsockopt(socket_fd, SOL_SOCKET, SO_REUSEPORT, &on, sizeof(on)) == -1)
+            {
+                close(socket_fd);
+                continue;
+            }
+        }
+
         if (bind(socket_fd, p->ai_addr, p->ai_addrlen) < 0)
         {
             close(socket_fd);
@@ -218,7 +358,7 @@ Socket::Socket(uint16_t port, bool verbose)
     freeaddrinfo(res);
     freeaddrinfo(local_addr_info);
 
-    if (listen(socket_fd, 5) < 0)
+    if (listen(socket_fd, SOMAXCONN) < 0)
     {
         throw std::runtime_error("Listen failed");
     }
@@ -237,8 +377,12 @@ Socket::Socket(int socket_fd, const std::string &sender_ip, uint16_t sender_port
     closed = false;
     all_messages_received = false;
     all_messages_sent = false;
-    read_queue = std::deque<char>();
-    write_queue = std::deque<char>();
+    binary = false;
+    output_bytes = 0;
+    read_offset = 0;
+    scanned = 0;
+    next_line_end = 0;
+    unreleased = 0;
 
     if (fcntl(socket_fd, F_SETFL, O_NONBLOCK) == -1)
         throw std::runtime_error(strerror(errno));
@@ -249,20 +393,42 @@ Socket::~Socket()
     close(socket_fd);
 }
 
-std::shared_ptr<Socket> Socket::accept_connection()
+std::shared_ptr<Socket> Socket::accept_connection(bool &back_off)
 {
     struct sockaddr_storage their_addr;
     socklen_t addr_size = sizeof(their_addr);
     int new_socket_fd = accept(socket_fd, (struct sockaddr *)&their_addr, &addr_size);
     if (new_socket_fd == -1)
-        throw std::runtime_error(strerror(errno));
+    {
+        back_off = handle_accept_error(errno);
+        return nullptr;
+    }
+
+    back_off = false;
+    return adopt_connection(new_socket_fd, their_addr);
+}
 
+bool Socket::handle_accept_error(int error)
+{
+    if (error == EAGAIN || error == EWOULDBLOCK || error == EINTR)
+        return false;
+
+    // Only a broken listening socket is fatal, anything else is about a single connection or a passing shortage.
+    if (error == EBADF || error == EFAULT || error == EINVAL || error == ENOTSOCK || error == EOPNOTSUPP)
+        throw std::runtime_error(strerror(error));
+
+    std::cerr << "Accept error: " << strerror(error) << '\n';
+    return error == EMFILE || error == ENFILE || error == ENOBUFS || error == ENOMEM;
+}
+
+std::shared_ptr<Socket> Socket::adopt_connection(int new_socket_fd, const struct sockaddr_storage &their_addr)
+{
     struct addrinfo *res = new addrinfo;
     memset(res, 0, sizeof(struct addrinfo));
 
     if (their_addr.ss_family == AF_INET)
     {
-        struct sockaddr_in *ipv4 = (struct sockaddr_in *)&their_addr;
+        const struct sockaddr_in *ipv4 = (const struct sockaddr_in *)&their_addr;
         res->ai_family = AF_INET;
         res->ai_addrlen = sizeof(struct sockaddr_in);
         res->ai_addr = (struct sockaddr *)new sockaddr_in;
@@ -270,7 +436,7 @@ std::shared_ptr<Socket> Socket::accept_connection()
     }
     else
     {
-        struct sockaddr_in6 *ipv6 = (struct sockaddr_in6 *)&their_addr;
+        const struct sockaddr_in6 *ipv6 = (const struct sockaddr_in6 *)&their_addr;
         res->ai_family = AF_INET6;
         res->ai_addrlen = sizeof(struct sockaddr_in6);
         res->ai_addr = (struct sockaddr *)new sockaddr_in6;
@@ -295,99 +461,258 @@ std::shared_ptr<Socket> Socket::accept_connection()
 
 void Socket::send(const std::string &message)
 {
-    write_queue.insert(write_queue.end(), message.begin(), message.end());
+    write_queue.append(message.data(), message.size());
+
+    queue_ring_output(message.size());
+
     if (verbose)
-    {
-        std::cout << '['
-                  << receiver_ip
-                  << ':'
-                  << receiver_port
-                  << ','
-                  << sender_ip
-                  << ':'
-                  << sender_port
-                  << ','
-                  << current_time_to_string()
-                  << "] "
-                  << message;
-    }
+        log_message(receiver_ip, receiver_port, sender_ip, sender_port, message);
 }
 
-std::string Socket::extract_message()
+void Socket::send(const Message &message)
 {
-    std::string message;
-    auto it = read_queue.begin();
-    while (it != read_queue.end() && message.size() < MAX_MESSAGE_SIZE)
+    // Binary frames always fit, only a long text message is put together outside of the ring.
+    size_t length = binary ? message.binary_size() : message.serialized_size();
+    if (length > RING_BUFFER_SLACK)
     {
-        message += *it;
-        if (*it == '\n')
-            break;
-        ++it;
+        send(message.to_string());
+        return;
     }
 
-    if (!message.empty() && (message.size() == MAX_MESSAGE_SIZE || message.back() == '\n'))
+    char *buffer = write_queue.prepare(length);
+    if (binary)
+        message.serialize_binary_into(buffer);
+    else
+        message.serialize_into(buffer);
+    write_queue.commit_prepared(length);
+
+    queue_ring_output(length);
+
+    if (verbose)
+        log_message(receiver_ip, receiver_port, sender_ip, sender_port, std::string_view(buffer, length));
+}
+
+void Socket::send(SharedMessage &message)
+{
+    send(message.buffer(binary));
+}
+
+void Socket::send(const SharedBuffer &message)
+{
+    output_chunks.push_back(OutputChunk{message, message->size()});
+    output_bytes += message->size();
+
+    if (verbose)
+        log_message(receiver_ip, receiver_port, sender_ip, sender_port, *message);
+}
+
+std::string_view Socket::next_message()
+{
+    release_message();
+
+    size_t length = 0;
+    char first = read_queue.empty() ? '\0' : read_queue.view(1)[0];
+    if (binary && !read_queue.empty() && is_binary_frame(first))
     {
-        read_queue.erase(read_queue.begin(), it + 1);
+        // A binary frame starts with its length. A byte that is no frame length, such as a stray line end,
+        // is taken alone to get past it, so the frames after it stay in sync.
+        size_t frame_length = is_binary_frame_length(first) ? static_cast<unsigned char>(first) : 1;
+        if (read_queue.size() >= frame_length)
+            length = frame_length;
     }
     else
+    {
+        // A message ends with a newline or is cut at the maximum message size.
+        // Line ends of everything received are found in one pass, the messages after this one are taken from them.
+        if (next_line_end == line_ends.size())
+            scan_line_ends();
+
+        if (next_line_end < line_ends.size() && line_ends[next_line_end] - read_offset <= MAX_MESSAGE_SIZE)
+            length = line_ends[next_line_end] - read_offset;
+        else if (read_queue.size() >= MAX_MESSAGE_SIZE)
+            length = MAX_MESSAGE_SIZE;
+    }
+
+    if (length == 0)
     {
         if (closed)
             all_messages_received = true;
-        message.clear();
+        return std::string_view();
     }
 
-    if (verbose && !message.empty())
-        std::cout << '['
-                  << sender_ip
-                  << ':'
-                  << sender_port
-                  << ','
-                  << receiver_ip
-                  << ':'
-                  << receiver_port
-                  << ','
-                  << current_time_to_string()
-                  << "] "
-                  << message;
+    std::string_view message = read_queue.view(length);
+    unreleased = length;
+
+    if (verbose)
+        log_message(sender_ip, sender_port, receiver_ip, receiver_port, message);
 
     return message;
 }
 
+void Socket::release_message()
+{
+    read_queue.consume(unreleased);
+    read_offset += unreleased;
+    unreleased = 0;
+
+    // Line ends inside the released bytes are dropped, a binary frame may contain newline bytes.
+    while (next_line_end < line_ends.size() && line_ends[next_line_end] <= read_offset)
+        next_line_end++;
+    scanned = std::max(scanned, read_offset);
+}
+
+std::string Socket::extract_message()
+{
+    std::string message(next_message());
+    release_message();
+    return message;
+}
+
 void Socket::handle_write()
 {
     if (closed && all_messages_sent)
         return;
 
-    if (write_queue.empty())
+    if (output_chunks.empty())
     {
         if (closed)
             all_messages_sent = true;
         return;
     }
 
-    std::vector<char> buffer(write_queue.begin(), write_queue.end());
-    ssize_t bytes_sent = ::send(socket_fd, buffer.data(), buffer.size(), 0);
-    if (bytes_sent > 0)
-        write_queue.erase(write_queue.begin(), write_queue.begin() + bytes_sent);
-    else if (bytes_sent == 0)
+    iovec segments[MAX_OUTPUT_SEGMENTS];
+    int count = output_segments(segments, MAX_OUTPUT_SEGMENTS);
+
+    // MSG_NOSIGNAL turns a reset peer into EPIPE instead of SIGPIPE, which is handled as a hangup.
+    struct msghdr header = {};
+    header.msg_iov = segments;
+    header.msg_iovlen = count;
+
+    ssize_t bytes_sent = ::sendmsg(socket_fd, &header, MSG_NOSIGNAL);
+    if (bytes_sent >= 0)
+        handle_sent(bytes_sent);
+    else if (errno != EWOULDBLOCK)
+        handle_error(errno);
+}
+
+int Socket::output_segments(iovec *segments, int max_segments) const
+{
+    // Ring segments and shared buffers go out in one call, in the order they were queued.
+    int count = 0;
+    size_t ring_offset = 0;
+    for (auto &chunk : output_chunks)
+    {
+        if (count + 2 > max_segments)
+            break;
+
+        if (chunk.buffer == nullptr)
+        {
+            count += write_queue.readable_segments(segments + count, ring_offset, chunk.length);
+            ring_offset += chunk.length;
+        }
+        else
+        {
+            segments[count].iov_base = const_cast<char *>(chunk.buffer->data() + chunk.buffer->size() - chunk.length);
+            segments[count].iov_len = chunk.length;
+            count++;
+        }
+    }
+
+    return count;
+}
+
+std::shared_ptr<const char[]> Socket::output_storage() const
+{
+    return write_queue.storage();
+}
+
+void Socket::handle_sent(size_t bytes_sent)
+{
+    if (bytes_sent == 0)
+    {
         closed = true;
-    else if (bytes_sent < 0 && errno != EWOULDBLOCK)
-        throw std::runtime_error(strerror(errno));
+        return;
+    }
+
+    consume_output(bytes_sent);
+    if (closed && output_chunks.empty())
+        all_messages_sent = true;
+}
+
+uint16_t Socket::local_port() const
+{
+    return sender_port;
+}
+
+bool Socket::has_pending_output() const
+{
+    return !output_chunks.empty();
+}
+
+size_t Socket::pending_output_bytes() const
+{
+    return output_bytes;
 }
 
+
 void Socket::handle_read()
 {
     if (closed)
         return;
 
-    char buffer[MAX_BUFFER_SIZE];
-    ssize_t bytes_received = ::recv(socket_fd, buffer, sizeof(buffer), 0);
-    if (bytes_received > 0)
-        read_queue.insert(read_queue.end(), buffer, buffer + bytes_received);
-    else if (bytes_received == 0)
+    while (true)
+    {
+        // Data is read straight into the free space of the ring.
+        iovec segments[2];
+        int count = input_segments(segments);
+        if (count == 0)
+            return;
+        size_t free_space = segments[0].iov_len + (count == 2 ? segments[1].iov_len : 0);
+
+        ssize_t bytes_received = ::readv(socket_fd, segments, count);
+        if (bytes_received >= 0)
+            handle_received(bytes_received);
+        else if (errno != EWOULDBLOCK)
+            handle_error(errno);
+
+        if (bytes_received < static_cast<ssize_t>(free_space))
+            break;
+    }
+}
+
+int Socket::input_segments(iovec segments[2])
+{
+    // Messages are at most MAX_MESSAGE_SIZE bytes and are handled as they come, only a flooding peer fills the queue.
+    if (read_queue.size() >= MAX_READ_QUEUE_SIZE)
+    {
+        std::cerr << "Read queue overflow\n";
+        abandon();
+        return 0;
+    }
+
+    return read_queue.writable_segments(segments);
+}
+
+void Socket::handle_received(size_t bytes_received)
+{
+    if (bytes_received == 0)
         closed = true;
-    else if (bytes_received < 0 && errno != EWOULDBLOCK)
-        throw std::runtime_error(strerror(errno));
+    else
+        read_queue.commit(bytes_received);
+}
+
+void Socket::handle_error(int error)
+{
+    // A reset peer ends only its own connection, it is closed like one that has hung up.
+    std::cerr << "Connection error: " << strerror(error) << '\n';
+    abandon();
+}
+
+void Socket::abandon()
+{
+    closed = true;
+    all_messages_received = true;
+    all_messages_sent = true;
 }
 
 void Socket::set_timeout(int seconds)
@@ -402,14 +727,61 @@ void Socket::set_timeout(int seconds)
 void Socket::await_message(MessageType type, int timeout)
 {
     awaited_message = type;
-    timestamp = get_current_time_in_millis() + timeout * 1000;
+    deadline = get_monotonic_time_in_millis() + timeout * 1000LL;
 }
 
-bool Socket::is_timed_out() const
+bool Socket::is_timed_out(long long now) const
 {
-    if (!awaited_message.has_value())
-        return false;
+    return awaited_message.has_value() && now >= deadline;
+}
+
+/*
+ * Private functions
+ */
+
+void Socket::queue_ring_output(size_t length)
+{
+    if (!output_chunks.empty() && output_chunks.back().buffer == nullptr)
+        output_chunks.back().length += length;
+    else
+        output_chunks.push_back(OutputChunk{nullptr, length});
+    output_bytes += length;
+}
+
+void Socket::consume_output(size_t length)
+{
+    output_bytes -= length;
+
+    while (length > 0)
+    {
+        OutputChunk &chunk = output_chunks.front();
+        size_t consumed = std::min(length, chunk.length);
 
-    auto current_time = get_current_time_in_millis();
-    return current_time > timestamp;
+        if (chunk.buffer == nullptr)
+            write_queue.consume(consumed);
+
+        chunk.length -= consumed;
+        length -= consumed;
+
+        if (chunk.length == 0)
+            output_chunks.pop_front();
+    }
+}
+
+void Socket::scan_line_ends()
+{
+    size_t received = read_offset + read_queue.size();
+    if (scanned >= received)
+        return;
+
+    line_ends.clear();
+    next_line_end = 0;
+
+    iovec segments[2];
+    int segments_count = read_queue.readable_segments(segments, scanned - read_offset);
+    for (int i = 0; i < segments_count; i++)
+    {
+        find_line_ends(static_cast<const char *>(segments[i].iov_base), segments[i].iov_len, scanned, line_ends);
+        scanned += segments[i].iov_len;
+    }
 }
\ No newline at end of file
@@ -4,13 +4,22 @@
 #include <cstdint>
 #include <memory>
 #include <netdb.h>
-#include <deque>
+#include <sys/socket.h>
 #include <cstdint>
+#include <deque>
 #include <optional>
+#include <string_view>
+#include <vector>
 #include "common.h"
+#include "frame-scanner.h"
+#include "ring-buffer.h"
+#include "timer-wheel.h"
 
 #define MAX_MESSAGE_SIZE 50
-#define MAX_BUFFER_SIZE 4096
+#define STATS_INTERVAL 1000
+#define MAX_OUTPUT_SEGMENTS 16
+#define ACCEPT_BACKOFF_MS 100
+#define MAX_READ_QUEUE_SIZE RING_BUFFER_CAPACITY
 
 /**
  * @brief IP version
@@ -37,6 +46,13 @@ uint16_t read_port(const char *port);
  */
 long long get_current_time_in_millis();
 
+/**
+ * @brief Get time of a monotonic clock in milliseconds, unaffected by wall clock changes
+ *
+ * @return Monotonic time in milliseconds
+ */
+long long get_monotonic_time_in_millis();
+
 /**
  * @brief Get current time as string
  *
@@ -44,14 +60,113 @@ long long get_current_time_in_millis();
  */
 std::string current_time_to_string();
 
+/**
+ * @brief Event loop statistics
+ *
+ * Counts loop wakeups and handled messages, the summary is printed at the
+ * first wakeup after the reporting interval, so an idle loop prints nothing.
+ */
+class LoopStats
+{
+private:
+    bool enabled;
+    std::string name;
+    long long wakeups;
+    long long messages;
+    size_t peak_output;
+    long long slow_clients;
+    long long interval_start;
+
+public:
+    /**
+     * @brief Construct a new LoopStats object
+     *
+     * @param enabled Whether to collect and print statistics
+     * @param name Name of the loop used in the report
+     */
+    LoopStats(bool enabled, const std::string &name);
+
+    /**
+     * @brief Count a wakeup and print the report if the interval has passed
+     */
+    void wakeup();
+
+    /**
+     * @brief Count handled messages
+     *
+     * @param count Number of messages
+     */
+    void handled(int count);
+
+    /**
+     * @brief Record the number of bytes waiting in a writing queue
+     *
+     * @param bytes Number of queued bytes
+     */
+    void queued(size_t bytes);
+
+    /**
+     * @brief Count a client whose writing queue has exceeded its limit
+     */
+    void slow_client();
+};
+
+/**
+ * @brief Immutable serialized message shared by the writing queues of many sockets
+ */
+using SharedBuffer = std::shared_ptr<const std::string>;
+
+/**
+ * @brief Message serialized at most once for each wire format, shared by the writing queues of many sockets
+ */
+class SharedMessage
+{
+private:
+    AnyMessage message;
+    SharedBuffer text;
+    SharedBuffer binary;
+
+public:
+    /**
+     * @brief Construct a new SharedMessage object
+     *
+     * @param message Message
+     */
+    SharedMessage(const AnyMessage &message);
+
+    /**
+     * @brief Get the message serialized in a wire format, serialize it on first use
+     *
+     * @param binary Whether to get the binary frame instead of the text
+     * @return Serialized message
+     */
+    const SharedBuffer &buffer(bool binary);
+};
+
+/**
+ * @brief Part of the writing queue, bytes stored in the ring or a shared buffer
+ */
+struct OutputChunk
+{
+    SharedBuffer buffer;
+    size_t length;
+};
+
 /**
  * @brief Socket class
  */
 class Socket
 {
 private:
-    std::deque<char> read_queue;
-    std::deque<char> write_queue;
+    RingBuffer read_queue;
+    RingBuffer write_queue;
+    std::deque<OutputChunk> output_chunks;
+    size_t output_bytes;
+    size_t read_offset;
+    size_t scanned;
+    std::vector<size_t> line_ends;
+    size_t next_line_end;
+    size_t unreleased;
     bool verbose;
     std::string sender_ip;
     uint16_t sender_port;
@@ -63,9 +178,11 @@ public:
     bool closed;
     bool all_messages_received;
     bool all_messages_sent;
+    bool binary;
 
     std::optional<MessageType> awaited_message;
-    long long timestamp;
+    long long deadline;
+    Timer timer;
 
     /**
      * @brief Construct a new Socket object
@@ -82,8 +199,9 @@ public:
      *
      * @param port Port number
      * @param verbose Whether to print network logs
+     * @param reuse_port Whether other sockets can listen on the same port (SO_REUSEPORT)
      */
-    Socket(uint16_t port, bool verbose = false);
+    Socket(uint16_t port, bool verbose = false, bool reuse_port = false);
 
     /**
      * @brief Construct a new Socket object
@@ -104,9 +222,35 @@ public:
 
     /**
      * @brief Accept connection on the server side
+     * @param back_off Set if accepting should pause, see handle_accept_error
+     * @return New socket object representing the connection, nullptr if accepting failed
+     * @throws std::runtime_error If the listening socket cannot accept anymore
+     */
+    std::shared_ptr<Socket> accept_connection(bool &back_off);
+
+    /**
+     * @brief Handle a failed accept on the listening socket, the failed connection is dropped and the socket keeps listening
+     *
+     * @param error Error number
+     * @return true if accepting should pause for ACCEPT_BACKOFF_MS because descriptors or memory ran out, false otherwise
+     * @throws std::runtime_error If the listening socket cannot accept anymore
+     */
+    bool handle_accept_error(int error);
+
+    /**
+     * @brief Wrap connection accepted on the server side
+     * @param new_socket_fd Accepted socket file descriptor
+     * @param their_addr Address of the peer
      * @return New socket object representing the connection
      */
-    std::shared_ptr<Socket> accept_connection();
+    std::shared_ptr<Socket> adopt_connection(int new_socket_fd, const struct sockaddr_storage &their_addr);
+
+    /**
+     * @brief Get local port number
+     *
+     * @return Port number the socket is bound to
+     */
+    uint16_t local_port() const;
 
     /**
      * @brief Put data into the writing queue
@@ -114,6 +258,41 @@ public:
      */
     void send(const std::string &message);
 
+    /**
+     * @brief Serialize message straight into the writing queue
+     * @param message Message to be put into the writing queue
+     */
+    void send(const Message &message);
+
+    /**
+     * @brief Put shared message into the writing queue in the wire format of the socket
+     * @param message Message, possibly queued on other sockets too
+     */
+    void send(SharedMessage &message);
+
+    /**
+     * @brief Put shared buffer into the writing queue without copying it
+     * @param message Serialized message, possibly queued on other sockets too
+     */
+    void send(const SharedBuffer &message);
+
+    /**
+     * @brief Take the next complete message from the reading queue without copying it
+     *
+     * The message is left in the reading queue until it is released, so the
+     * view points straight into the receive buffer and stays valid until the
+     * release. A message that was not released is released by the next call.
+     * A binary socket takes binary frames, a byte that starts no frame is taken alone.
+     *
+     * @return View of the message, empty if no complete message has been received
+     */
+    std::string_view next_message();
+
+    /**
+     * @brief Drop the message taken by the last next_message from the reading queue
+     */
+    void release_message();
+
     /**
      * @brief Read data from the reading queue
      * @return Data read from the reading queue
@@ -125,11 +304,73 @@ public:
      */
     void handle_write();
 
+    /**
+     * @brief Check if there is data waiting in the writing queue
+     *
+     * @return Has pending output
+     */
+    bool has_pending_output() const;
+
+    /**
+     * @brief Get number of bytes waiting in the writing queue, shared buffers included
+     *
+     * @return Number of queued bytes
+     */
+    size_t pending_output_bytes() const;
+
     /**
      * @brief Read as many bytes as possible from the socket
      */
     void handle_read();
 
+    /**
+     * @brief Get free space of the reading queue as segments for readv, valid until handle_received
+     *
+     * The reading queue holds at most MAX_READ_QUEUE_SIZE unhandled bytes, a
+     * peer that sends more is abandoned instead of the queue growing.
+     *
+     * @param segments Two segments to be filled
+     * @return Number of filled segments, 0 if the socket has been abandoned
+     */
+    int input_segments(iovec segments[2]);
+
+    /**
+     * @brief Account bytes read into the input segments
+     * @param bytes_received Number of bytes read, 0 if the peer has closed the connection
+     */
+    void handle_received(size_t bytes_received);
+
+    /**
+     * @brief Treat a failed read or write as a hangup, the queued output is abandoned
+     * @param error Error number of the failed call
+     */
+    void handle_error(int error);
+
+    /**
+     * @brief Close the socket at once, the queued input and output are abandoned
+     */
+    void abandon();
+
+    /**
+     * @brief Get the writing queue as segments for writev, valid until handle_sent
+     * @param segments Segments to be filled
+     * @param max_segments Maximum number of segments
+     * @return Number of filled segments
+     */
+    int output_segments(iovec *segments, int max_segments) const;
+
+    /**
+     * @brief Get storage the output segments point to, it stays valid while more data is queued
+     * @return Storage
+     */
+    std::shared_ptr<const char[]> output_storage() const;
+
+    /**
+     * @brief Account bytes written from the output segments
+     * @param bytes_sent Number of bytes written
+     */
+    void handle_sent(size_t bytes_sent);
+
     /**
      * @brief Set timeout on the socket
      * @param seconds timeout in seconds
@@ -137,7 +378,7 @@ public:
     void set_timeout(int seconds);
 
     /**
-     * @brief Set message to be awaited and timestamp
+     * @brief Set message to be awaited and deadline on the monotonic clock
      * @param type message type to be awaited
      * @param timeout timeout in seconds
      */
@@ -146,9 +387,28 @@ public:
     /**
     * @brief Check if the socket has timed out
      *
+     * @param now Monotonic time in milliseconds
      * @return Is timed out
     */
-     bool is_timed_out() const;
+     bool is_timed_out(long long now) const;
+
+private:
+    /**
+     * @brief Account bytes stored in the ring of the writing queue
+     * @param length Number of bytes
+     */
+    void queue_ring_output(size_t length);
+
+    /**
+     * @brief Drop sent bytes from the writing queue
+     * @param length Number of sent bytes
+     */
+    void consume_output(size_t length);
+
+    /**
+     * @brief Find line ends in the bytes of the reading queue that have not been scanned yet
+     */
+    void scan_line_ends();
 };
 
 #endif // NETWORK_COMMON_H
\ No newline at end of file
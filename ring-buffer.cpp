@@ -0,0 +1,178 @@
+#include <algorithm>
+#include <string.h>
+#include <stdexcept>
+
+#include "ring-buffer.h"
+
+static size_t round_up_to_power_of_two(size_t value)
+{
+    size_t power = 1;
+    while (power < value)
+        power <<= 1;
+    return power;
+}
+
+RingBuffer::RingBuffer(size_t capacity)
+{
+    this->capacity = round_up_to_power_of_two(capacity);
+    data = std::shared_ptr<char[]>(new char[this->capacity + RING_BUFFER_SLACK]);
+    head = 0;
+    tail = 0;
+}
+
+size_t RingBuffer::size() const
+{
+    return tail - head;
+}
+
+bool RingBuffer::empty() const
+{
+    return head == tail;
+}
+
+void RingBuffer::append(const char *bytes, size_t length)
+{
+    reserve(length);
+
+    size_t offset = tail & (capacity - 1);
+    size_t first = std::min(length, capacity - offset);
+    memcpy(data.get() + offset, bytes, first);
+    memcpy(data.get(), bytes + first, length - first);
+
+    tail += length;
+}
+
+void RingBuffer::consume(size_t length)
+{
+    head += length;
+}
+
+size_t RingBuffer::find(char byte, size_t from, size_t limit) const
+{
+    limit = std::min(limit, size());
+    if (from >= limit)
+        return std::string::npos;
+
+    size_t offset = (head + from) & (capacity - 1);
+    size_t first = std::min(limit - from, capacity - offset);
+
+    const char *found = static_cast<const char *>(memchr(data.get() + offset, byte, first));
+    if (found != nullptr)
+        return from + (found - (data.get() + offset));
+
+    found = static_cast<const char *>(memchr(data.get(), byte, limit - from - first));
+    if (found != nullptr)
+        return from + first + (found - data.get());
+
+    return std::string::npos;
+}
+
+std::string_view RingBuffer::view(size_t length)
+{
+    size_t offset = head & (capacity - 1);
+    if (offset + length > capacity)
+    {
+        // The wrapped part is copied into the slack right after the ring.
+        size_t wrapped = offset + length - capacity;
+        if (wrapped > RING_BUFFER_SLACK)
+            throw std::invalid_argument("Range too long to be viewed");
+        memcpy(data.get() + capacity, data.get(), wrapped);
+    }
+
+    return std::string_view(data.get() + offset, length);
+}
+
+int RingBuffer::readable_segments(iovec segments[2], size_t from, size_t length) const
+{
+    if (from >= size())
+        return 0;
+    length = std::min(length, size() - from);
+
+    size_t offset = (head + from) & (capacity - 1);
+    size_t first = std::min(length, capacity - offset);
+
+    segments[0].iov_base = data.get() + offset;
+    segments[0].iov_len = first;
+    if (first == length)
+        return 1;
+
+    segments[1].iov_base = data.get();
+    segments[1].iov_len = length - first;
+    return 2;
+}
+
+int RingBuffer::writable_segments(iovec segments[2])
+{
+    if (size() == capacity)
+        reserve(capacity);
+
+    size_t free_space = capacity - size();
+    size_t offset = tail & (capacity - 1);
+    size_t first = std::min(free_space, capacity - offset);
+
+    segments[0].iov_base = data.get() + offset;
+    segments[0].iov_len = first;
+    if (first == free_space)
+        return 1;
+
+    segments[1].iov_base = data.get();
+    segments[1].iov_len = free_space - first;
+    return 2;
+}
+
+void RingBuffer::commit(size_t length)
+{
+    tail += length;
+}
+
+char *RingBuffer::prepare(size_t length)
+{
+    if (length > RING_BUFFER_SLACK)
+        throw std::invalid_argument("Range too long to be prepared");
+
+    reserve(length);
+    return data.get() + (tail & (capacity - 1));
+}
+
+void RingBuffer::commit_prepared(size_t length)
+{
+    size_t offset = tail & (capacity - 1);
+    if (offset + length > capacity)
+        memcpy(data.get(), data.get() + capacity, offset + length - capacity);
+
+    tail += length;
+}
+
+std::shared_ptr<const char[]> RingBuffer::storage() const
+{
+    return data;
+}
+
+/*
+ * Private functions
+ */
+
+void RingBuffer::reserve(size_t free_space)
+{
+    if (capacity - size() >= free_space)
+        return;
+
+    size_t new_capacity = round_up_to_power_of_two(size() + free_space);
+    std::shared_ptr<char[]> new_data(new char[new_capacity + RING_BUFFER_SLACK]);
+
+    size_t stored = size();
+    iovec segments[2];
+    int count = readable_segments(segments);
+
+    size_t copied = 0;
+    for (int i = 0; i < count; i++)
+    {
+        memcpy(new_data.get() + copied, segments[i].iov_base, segments[i].iov_len);
+        copied += segments[i].iov_len;
+    }
+
+    data = std::move(new_data);
+    capacity = new_capacity;
+    head = 0;
+    tail = stored;
+}
\ No newline at end of file
@@ -0,0 +1,149 @@
+#ifndef RING_BUFFER_H
+#define RING_BUFFER_H
+
+#include <cstddef>
+#include <memory>
+#include <string>
+#include <string_view>
+#include <sys/uio.h>
+
+#define RING_BUFFER_CAPACITY 4096
+#define RING_BUFFER_SLACK 64
+
+/**
+ * @brief Byte queue stored in a ring with power-of-two capacity
+ *
+ * Head and tail run freely and are masked on access, so the stored bytes
+ * and the free space are both at most two contiguous segments which can be
+ * passed to readv/writev directly. The capacity doubles when an append
+ * does not fit, which keeps the ring from overflowing but never happens
+ * for well-behaved peers. A few bytes of slack after the ring let short
+ * wrapped ranges be viewed and written contiguously. Storage is shared, so I/O still in
+ * flight can keep the bytes it points to alive while the ring grows.
+ */
+class RingBuffer
+{
+private:
+    std::shared_ptr<char[]> data;
+    size_t capacity;
+    size_t head;
+    size_t tail;
+
+public:
+    /**
+     * @brief Construct a new RingBuffer object
+     *
+     * @param capacity Initial capacity, rounded up to a power of two
+     */
+    RingBuffer(size_t capacity = RING_BUFFER_CAPACITY);
+
+    /**
+     * @brief Get number of stored bytes
+     *
+     * @return Number of stored bytes
+     */
+    size_t size() const;
+
+    /**
+     * @brief Check if no bytes are stored
+     *
+     * @return Is empty
+     */
+    bool empty() const;
+
+    /**
+     * @brief Copy bytes to the end of the buffer
+     *
+     * @param bytes Bytes
+     * @param length Number of bytes
+     */
+    void append(const char *bytes, size_t length);
+
+    /**
+     * @brief Drop bytes from the front of the buffer
+     *
+     * @param length Number of bytes, at most size()
+     */
+    void consume(size_t length);
+
+    /**
+     * @brief Find byte among the first bytes of the buffer
+     *
+     * @param byte Byte to be found
+     * @param from Offset to start the search at
+     * @param limit Offset to end the search at
+     * @return Offset of the byte, std::string::npos if not found
+     */
+    size_t find(char byte, size_t from, size_t limit) const;
+
+    /**
+     * @brief View bytes from the front of the buffer without copying them out
+     *
+     * The view stays valid until bytes are appended or another view is taken,
+     * consuming the bytes does not invalidate it.
+     *
+     * @param length Number of bytes, at most size() and at most RING_BUFFER_SLACK if they wrap around
+     * @return View of the bytes
+     */
+    std::string_view view(size_t length);
+
+    /**
+     * @brief Get stored bytes as segments for writev
+     *
+     * @param segments Two segments to be filled
+     * @param from Offset of the first byte
+     * @param length Number of bytes, all bytes after the offset by default
+     * @return Number of filled segments
+     */
+    int readable_segments(iovec segments[2], size_t from = 0, size_t length = std::string::npos) const;
+
+    /**
+     * @brief Get free space as segments for readv, grow the buffer if it is full
+     *
+     * @param segments Two segments to be filled
+     * @return Number of filled segments
+     */
+    int writable_segments(iovec segments[2]);
+
+    /**
+     * @brief Mark bytes written into the free space as stored
+     *
+     * @param length Number of bytes, at most the size of the free space
+     */
+    void commit(size_t length);
+
+    /**
+     * @brief Get contiguous space at the end of the buffer, grow the buffer if the bytes do not fit
+     *
+     * Space that wraps around runs into the slack, commit_prepared moves the
+     * wrapped part to the front of the ring.
+     *
+     * @param length Number of bytes, at most RING_BUFFER_SLACK
+     * @return Space for the bytes
+     */
+    char *prepare(size_t length);
+
+    /**
+     * @brief Mark bytes written into the prepared space as stored
+     *
+     * @param length Number of bytes, at most the number passed to prepare
+     */
+    void commit_prepared(size_t length);
+
+    /**
+     * @brief Get storage the segments point to, it outlives the ring growing
+     *
+     * @return Storage
+     */
+    std::shared_ptr<const char[]> storage() const;
+
+private:
+    /**
+     * @brief Grow the buffer so at least the given number of bytes fits in
+     *
+     * @param free_space Number of bytes that has to fit in
+     */
+    void reserve(size_t free_space);
+};
+
+#endif // RING_BUFFER_H
\ No newline at end of file
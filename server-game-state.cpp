@@ -5,34 +5,116 @@
 
 #include "server-game-state.h"
 
-ServerGameState::ServerGameState(const std::string &filename, int timeout)
+/*
+ * Scoring tables
+ */
+
+/**
+ * @brief Penalty points of a deal type
+ */
+struct PenaltyTable
 {
-    game_ended = false;
-    this->timeout = timeout;
-    order = {Position::North, Position::East, Position::South, Position::West};
+    int card_points[CARDS_IN_DECK];
+    int trick_points;
+    int seventh_and_last_trick_points;
+};
+
+/**
+ * @brief Check if a deal type scores by the rule of another deal type, the bandit scores by all of them
+ *
+ * @param deal_type Deal type
+ * @param rule Deal type whose rule is checked
+ * @return Scores by the rule
+ */
+static constexpr bool scores_by(DealType deal_type, DealType rule)
+{
+    return deal_type == rule || deal_type == DealType::BANDIT;
+}
+
+/**
+ * @brief Build penalty table of a deal type
+ *
+ * @param deal_type Deal type
+ * @return Penalty table
+ */
+static constexpr PenaltyTable make_penalty_table(DealType deal_type)
+{
+    PenaltyTable table = {};
+
+    for (int id = 0; id < CARDS_IN_DECK; id++)
+    {
+        Card card(static_cast<uint8_t>(id));
+        bool heart = card.color() == Color::Hearts;
+
+        if (scores_by(deal_type, DealType::HEART) && heart)
+            table.card_points[id] += 1;
+        if (scores_by(deal_type, DealType::QUEEN) && card.figure() == "Q")
+            table.card_points[id] += 5;
+        if (scores_by(deal_type, DealType::LORD) && (card.figure() == "J" || card.figure() == "K"))
+            table.card_points[id] += 2;
+        if (scores_by(deal_type, DealType::KING_HEART) && card.figure() == "K" && heart)
+            table.card_points[id] += 18;
+    }
+
+    table.trick_points = scores_by(deal_type, DealType::TRICK) ? 1 : 0;
+    table.seventh_and_last_trick_points = scores_by(deal_type, DealType::SEVENTH_LAST) ? 10 : 0;
 
+    return table;
+}
+
+// Indexed by the deal type's value, index 0 is unused.
+static constexpr PenaltyTable PENALTY_TABLES[8] = {
+    {},
+    make_penalty_table(DealType::TRICK),
+    make_penalty_table(DealType::HEART),
+    make_penalty_table(DealType::QUEEN),
+    make_penalty_table(DealType::LORD),
+    make_penalty_table(DealType::KING_HEART),
+    make_penalty_table(DealType::SEVENTH_LAST),
+    make_penalty_table(DealType::BANDIT),
+};
+
+std::shared_ptr<const GameDefinition> GameDefinition::from_file(const std::string &filename)
+{
     std::ifstream file(filename);
     if (!file)
         throw std::runtime_error("Could not open file");
 
-    hands = {{}, {}, {}, {}};
+    auto definition = std::make_shared<GameDefinition>();
+    definition->hands = {{}, {}, {}, {}};
 
     std::string line;
     while (std::getline(file, line))
     {
-        deal_types.push_back(::from_string<DealType>(line.substr(0, 1)));
-        starting_players.push_back(::from_string<Position>(line.substr(1, 1)));
+        definition->deal_types.push_back(::from_string<DealType>(line.substr(0, 1)));
+        definition->starting_players.push_back(::from_string<Position>(line.substr(1, 1)));
 
         for (int i = 0; i < 4; i++)
         {
             std::getline(file, line);
-            std::vector<Card> hand = Card::parse_cards(line);
-            hands[i].push_back(hand);
+            CardList hand = Card::parse_cards(line);
+            definition->hands[i].push_back(hand);
         }
     }
 
     file.close();
 
+    return definition;
+}
+
+ServerGameState::ServerGameState(const std::string &filename, int timeout)
+    : ServerGameState(GameDefinition::from_file(filename), timeout)
+{
+}
+
+ServerGameState::ServerGameState(std::shared_ptr<const GameDefinition> definition, int timeout, bool auto_play)
+{
+    game_ended = false;
+    this->timeout = timeout;
+    this->auto_play = auto_play;
+    this->definition = definition;
+    order = {Position::North, Position::East, Position::South, Position::West};
+
     player_sockets[Position::North] = nullptr;
     player_sockets[Position::East] = nullptr;
     player_sockets[Position::South] = nullptr;
@@ -43,6 +125,8 @@ ServerGameState::ServerGameState(const std::string &filename, int timeout)
     current_move = 0;
 
     deal_started = false;
+    for (CardMask &hand : current_hands)
+        hand = 0;
 
     for (auto &position : order)
     {
@@ -55,7 +139,7 @@ std::optional<BUSYMessage> ServerGameState::new_player(Position position, std::s
 {
     if (player_sockets[position] != nullptr)
     {
-        std::vector<Position> busy_positions;
+        PositionList busy_positions;
         for (auto &position : order)
             if (player_sockets[position] != nullptr || player_sockets[position] == socket)
                 busy_positions.push_back(position);
@@ -97,24 +181,23 @@ void ServerGameState::start_deal()
     current_deal++;
     deal_started = true;
 
-    deal_type = deal_types[current_deal - 1];
-    starting_player = starting_players[current_deal - 1];
+    deal_type = definition->deal_types[current_deal - 1];
+    starting_player = definition->starting_players[current_deal - 1];
 
     starting_hands = {{}, {}, {}, {}};
 
     for (int i = 0; i < 4; i++)
     {
-        std::vector<Card> hand = hands[i][current_deal - 1];
+        const CardList &hand = definition->hands[i][current_deal - 1];
         Position position = order[i];
 
         starting_hands[i] = hand;
+        current_hands[i] = cards_to_mask(hand);
 
         send_deal_message(position);
         deal_scores[position] = 0;
     }
 
-    current_hands = starting_hands;
-
     current_trick = 0;
     trick_started = false;
     current_move = 0;
@@ -124,12 +207,18 @@ void ServerGameState::start_deal()
 }
 
 void ServerGameState::continue_game()
+{
+    while (are_players_ready() && !game_ended && !awaited_player.has_value())
+        advance_game();
+}
+
+void ServerGameState::advance_game()
 {
     if (!are_players_ready())
         return;
 
     if (!deal_started) {
-        if (current_deal == static_cast<int>(deal_types.size())) {
+        if (current_deal == static_cast<int>(definition->deal_types.size())) {
             end_game();
             return;
         }
@@ -173,8 +262,9 @@ void ServerGameState::continue_trick()
         calculate_points();
         send_taken_messages();
 
-        if (current_trick == 13)
-            current_trick++;
+        // The deal ends after the last trick or as soon as no points are left to be taken.
+        if (current_trick == 13 || remaining_points() == 0)
+            current_trick = 14;
 
         return;
     }
@@ -182,6 +272,15 @@ void ServerGameState::continue_trick()
     if (!awaited_player.has_value())
     {
         int player_idx = (current_move + first_move) % 4;
+
+        // A forced move is played without a round trip, the player sees the card in the TAKEN message.
+        CardMask moves = valid_moves(player_idx);
+        if (auto_play && __builtin_popcountll(moves) == 1)
+        {
+            play_card(player_idx, Card(static_cast<uint8_t>(__builtin_ctzll(moves))));
+            return;
+        }
+
         awaited_player = order[player_idx];
 
         send_trick_message(awaited_player.value());
@@ -203,7 +302,7 @@ std::optional<WRONGMessage> ServerGameState::handle_trick_message(std::shared_pt
     if (trick_message.trick_number != current_trick)
         return wrong_message;
 
-    auto cards = trick_message.cards;
+    const CardList &cards = trick_message.cards;
 
     if (cards.empty())
         return wrong_message;
@@ -214,9 +313,7 @@ std::optional<WRONGMessage> ServerGameState::handle_trick_message(std::shared_pt
     if (!is_valid_move(last_card, position.value()))
         return wrong_message;
 
-    trick_cards.push_back(last_card);
-    current_hands[player_idx].erase(std::find(current_hands[player_idx].begin(), current_hands[player_idx].end(), last_card));
-    current_move++;
+    play_card(player_idx, last_card);
     awaited_player = std::nullopt;
     socket->awaited_message = std::nullopt;
 
@@ -235,7 +332,7 @@ void ServerGameState::send_trick_message(Position position)
 {
     TRICKMessage trick_message = TRICKMessage(current_trick, trick_cards);
 
-    player_sockets[position]->send(trick_message.to_string());
+    player_sockets[position]->send(trick_message);
     player_sockets[position]->await_message(MessageType::TRICK, timeout);
 }
 
@@ -258,8 +355,8 @@ void ServerGameState::rejoin_client(Position position)
 {
     send_deal_message(position);
 
-    for (const auto& taken_message: taken_messages) {
-        player_sockets[position]->send(taken_message.to_string());
+    for (auto& taken_message: taken_messages) {
+        player_sockets[position]->send(taken_message);
     }
 
     if (trick_started && awaited_player == position)
@@ -269,80 +366,71 @@ void ServerGameState::rejoin_client(Position position)
 void ServerGameState::send_deal_message(Position position)
 {
     int idx = position_order(position);
-    auto hand = starting_hands[idx];
+    const CardList &hand = starting_hands[idx];
 
     DEALMessage deal_message = DEALMessage(deal_type, starting_player, hand);
-    player_sockets[position]->send(deal_message.to_string());
+    player_sockets[position]->send(deal_message);
 }
 
 void ServerGameState::send_score_messages()
 {
-    SCOREMessage score_message = SCOREMessage(deal_scores);
-    TOTALMessage total_message = TOTALMessage(total_scores);
+    // Messages are serialized once for each wire format in use and shared by all players.
+    SharedMessage score_message = SharedMessage(SCOREMessage(deal_scores));
+    SharedMessage total_message = SharedMessage(TOTALMessage(total_scores));
 
     for (auto pos : order)
     {
-        player_sockets[pos]->send(score_message.to_string());
-        player_sockets[pos]->send(total_message.to_string());
+        player_sockets[pos]->send(score_message);
+        player_sockets[pos]->send(total_message);
     }
 }
 
 void ServerGameState::send_taken_messages()
 {
-    TAKENMessage taken_message = TAKENMessage(current_trick, trick_cards, order[first_move]);
-
-    taken_messages.push_back(taken_message);
+    // The message is serialized once for each wire format in use, shared by all players and kept for the ones rejoining.
+    taken_messages.emplace_back(TAKENMessage(current_trick, trick_cards, order[first_move]));
 
     for (auto pos: order)
-        player_sockets[pos]->send(taken_message.to_string());
+        player_sockets[pos]->send(taken_messages.back());
 }
 
 void ServerGameState::calculate_points()
 {
-    int winner = first_move;
-    Card lead_card = trick_cards[0];
-    Color lead_color = lead_card.color;
+    Color lead_color = trick_cards[0].color();
+    int winning_move = 0;
 
     for (int i = 1; i < 4; i++)
-        if (lead_card.compare(trick_cards[i], lead_color))
-        {
-            lead_card = trick_cards[i];
-            winner = (first_move + i) % 4;
-        }
+        if (trick_cards[winning_move].compare(trick_cards[i], lead_color))
+            winning_move = i;
 
-    first_move = winner;
-    int score = 0;
+    first_move = (first_move + winning_move) % 4;
 
-    if (deal_type == DealType::TRICK || deal_type == DealType::BANDIT)
-        score++;
-    if (deal_type == DealType::HEART || deal_type == DealType::BANDIT)
-    {
-        for (auto const &card : trick_cards)
-            if (card.color == Color::Hearts)
-                score++;
-    }
-    if (deal_type == DealType::QUEEN || deal_type == DealType::BANDIT) {
-        for (auto const &card: trick_cards)
-            if (card.figure == "Q")
-                score += 5;
-    }
-    if (deal_type == DealType::LORD || deal_type == DealType::BANDIT) {
-        for (auto const &card: trick_cards)
-            if (card.figure == "J" || card.figure == "K")
-                score += 2;
-    }
-    if (deal_type == DealType::KING_HEART || deal_type == DealType::BANDIT) {
-        for (auto const &card: trick_cards)
-            if (card.figure == "K" && card.color == Color::Hearts)
-                score += 18;
-    }
-    if (deal_type == DealType::SEVENTH_LAST || deal_type == DealType::BANDIT) {
-        if (current_trick == 7 || current_trick == 13)
-            score += 10;
-    }
+    const PenaltyTable &table = PENALTY_TABLES[static_cast<int>(deal_type)];
+    int score = table.trick_points;
+
+    for (Card card : trick_cards)
+        score += table.card_points[card.id()];
+    if (current_trick == 7 || current_trick == 13)
+        score += table.seventh_and_last_trick_points;
 
-    Position winner_pos = order[winner];
-    deal_scores[winner_pos] += score;
+    deal_scores[order[first_move]] += score;
+}
+
+int ServerGameState::remaining_points() const
+{
+    const PenaltyTable &table = PENALTY_TABLES[static_cast<int>(deal_type)];
+    int points = table.trick_points * (13 - current_trick);
+
+    if (current_trick < 7)
+        points += table.seventh_and_last_trick_points;
+    if (current_trick < 13)
+        points += table.seventh_and_last_trick_points;
+
+    CardMask cards_left = current_hands[0] | current_hands[1] | current_hands[2] | current_hands[3];
+    for (; cards_left != 0; cards_left &= cards_left - 1)
+        points += table.card_points[__builtin_ctzll(cards_left)];
+
+    return points;
 }
 
 void ServerGameState::end_game() {
@@ -356,25 +444,25 @@ void ServerGameState::end_game() {
 
 bool ServerGameState::is_valid_move(const Card &card, Position position)
 {
-    int player_idx = position_order(position);
-    auto player_hand = current_hands[player_idx];
-
-    std::vector<Card> valid_moves;
-    if (!trick_cards.empty())
-    {
-        auto lead_color = trick_cards[0].color;
-        for (auto player_card : player_hand)
-            if (player_card.color == lead_color)
-                valid_moves.push_back(player_card);
-    }
+    return (valid_moves(position_order(position)) & card_mask(card)) != 0;
+}
 
-    if (valid_moves.empty())
-        valid_moves = player_hand;
+CardMask ServerGameState::valid_moves(int player_idx) const
+{
+    CardMask hand = current_hands[player_idx];
+    if (trick_cards.empty())
+        return hand;
 
-    if (std::find(valid_moves.begin(), valid_moves.end(), card) == valid_moves.end())
-        return false;
+    // Cards of other colors are valid only if the player has none of the lead color.
+    CardMask lead_color_cards = hand & color_mask(trick_cards[0].color());
+    return lead_color_cards != 0 ? lead_color_cards : hand;
+}
 
-    return true;
+void ServerGameState::play_card(int player_idx, Card card)
+{
+    trick_cards.push_back(card);
+    current_hands[player_idx] &= ~card_mask(card);
+    current_move++;
 }
 
 int ServerGameState::position_order(Position position)
@@ -392,4 +480,4 @@ int ServerGameState::position_order(Position position)
     default:
         return -1;
     }
-}
+}
\ No newline at end of file
@@ -6,10 +6,29 @@
 #include "network-common.h"
 #include "common.h"
 
+/**
+ * @brief Game definition read from the game file, shared by all tables.
+ */
+struct GameDefinition
+{
+    std::vector<DealType> deal_types;
+    std::vector<std::vector<CardList>> hands;
+    std::vector<Position> starting_players;
+
+    /**
+     * @brief Read game definition from file
+     *
+     * @param filename File name
+     * @return Game definition
+     */
+    static std::shared_ptr<const GameDefinition> from_file(const std::string &filename);
+};
+
 class ServerGameState
 {
 public:
     int timeout;
+    bool auto_play;
 
     // current trick data
     int current_trick;
@@ -17,7 +36,7 @@ public:
     int first_move;
     bool trick_started;
 
-    std::vector<Card> trick_cards;
+    CardList trick_cards;
     std::optional<Position> awaited_player;
 
     // current deal data
@@ -27,19 +46,17 @@ public:
     DealType deal_type;
     Position starting_player;
 
-    std::vector<std::vector<Card>> current_hands;
-    std::vector<std::vector<Card>> starting_hands;
-    std::vector<TAKENMessage> taken_messages;
+    CardMask current_hands[4];
+    std::vector<CardList> starting_hands;
+    std::vector<SharedMessage> taken_messages;
 
     // Whole game data
     bool game_ended;
     std::vector<Position> order;
-    std::vector<DealType> deal_types;
-    std::vector<std::vector<std::vector<Card>>> hands;
-    std::vector<Position> starting_players;
+    std::shared_ptr<const GameDefinition> definition;
     std::map<Position, std::shared_ptr<Socket>> player_sockets;
-    std::map<Position, int> deal_scores;
-    std::map<Position, int> total_scores;
+    Scores deal_scores;
+    Scores total_scores;
 
     /**
      * @brief Construct a new Server Game State object
@@ -49,6 +66,15 @@ public:
      */
     ServerGameState(const std::string &filename, int timeout);
 
+    /**
+     * @brief Construct a new Server Game State object
+     *
+     * @param definition Game definition
+     * @param timeout Timeout
+     * @param auto_play Whether moves with only one valid card are played without asking the player
+     */
+    ServerGameState(std::shared_ptr<const GameDefinition> definition, int timeout, bool auto_play = false);
+
     /**
      * @brief New player
      *
@@ -78,7 +104,7 @@ public:
     void start_deal();
 
     /**
-     * @brief Continue game, send necessary messages, etc.
+     * @brief Continue game until it waits for a player, send necessary messages, etc.
      */
     void continue_game();
 
@@ -125,6 +151,11 @@ public:
 
 private:
 
+    /**
+     * @brief Advances the game by a single step.
+     */
+    void advance_game();
+
     /**
      * @brief Sends necessary messages to rejoin the client.
      *
@@ -154,6 +185,13 @@ private:
      */
     void calculate_points();
 
+    /**
+     * @brief Counts penalty points that can still be taken in the current deal.
+     *
+     * @return Points in the cards left in hands and in the tricks left to be played.
+     */
+    int remaining_points() const;
+
     /**
      * @brief Ends the game, disconnects clients, etc.
      */
@@ -167,6 +205,22 @@ private:
      */
     bool is_valid_move(const Card &card, Position position);
 
+    /**
+     * @brief Gets the cards the player could play now.
+     *
+     * @param player_idx The player's index in order.
+     * @return CardMask The valid cards.
+     */
+    CardMask valid_moves(int player_idx) const;
+
+    /**
+     * @brief Puts the player's card into the trick.
+     *
+     * @param player_idx The player's index in order.
+     * @param card The card.
+     */
+    void play_card(int player_idx, Card card);
+
     /**
      * @brief Translates the position to int in order.
      *
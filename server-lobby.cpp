@@ -0,0 +1,226 @@
+#include "server-lobby.h"
+
+TableDirectory::TableDirectory(int max_tables) : all_finished(false)
+{
+    this->max_tables = max_tables;
+    created_tables = 0;
+    finished_tables = 0;
+    next_table_id = 1;
+
+    for (auto position : {Position::North, Position::East, Position::South, Position::West})
+        open_seats[position] = {};
+}
+
+std::optional<int> TableDirectory::reserve(Position position, std::optional<int> table_id)
+{
+    std::lock_guard<std::mutex> lock(mutex);
+
+    if (table_id.has_value())
+    {
+        if (tables.find(table_id.value()) == tables.end())
+        {
+            if (max_tables != 0 && created_tables == max_tables)
+                return std::nullopt;
+            create_table(table_id.value());
+        }
+    }
+    else
+    {
+        auto &seats = open_seats[position];
+        if (!seats.empty())
+        {
+            table_id = *seats.begin();
+        }
+        else
+        {
+            if (max_tables != 0 && created_tables == max_tables)
+                return std::nullopt;
+
+            while (tables.find(next_table_id) != tables.end())
+                next_table_id++;
+
+            table_id = next_table_id++;
+            create_table(table_id.value());
+        }
+    }
+
+    TableSeats &table_seats = tables[table_id.value()];
+    if (table_seats.game_ended || table_seats.taken.count(position) != 0)
+        return std::nullopt;
+
+    table_seats.taken.insert(position);
+    open_seats[position].erase(table_id.value());
+
+    if (table_seats.taken.size() == POSITIONS_COUNT)
+        table_seats.game_started = true;
+
+    return table_id;
+}
+
+bool TableDirectory::release(int table_id, Position position)
+{
+    std::lock_guard<std::mutex> lock(mutex);
+
+    auto it = tables.find(table_id);
+    if (it == tables.end())
+        return false;
+
+    it->second.taken.erase(position);
+
+    // A table left empty before its game started would otherwise hold one of the -m tables forever.
+    if (!it->second.game_started && it->second.taken.empty())
+    {
+        tables.erase(it);
+        for (auto &[seat, seats] : open_seats)
+            seats.erase(table_id);
+        created_tables--;
+        return true;
+    }
+
+    if (!it->second.game_ended)
+        open_seats[position].insert(table_id);
+
+    return false;
+}
+
+void TableDirectory::end_game(int table_id)
+{
+    std::lock_guard<std::mutex> lock(mutex);
+
+    tables[table_id].game_ended = true;
+    for (auto &[position, seats] : open_seats)
+        seats.erase(table_id);
+}
+
+bool TableDirectory::remove(int table_id)
+{
+    std::lock_guard<std::mutex> lock(mutex);
+
+    tables.erase(table_id);
+    for (auto &[position, seats] : open_seats)
+        seats.erase(table_id);
+
+    finished_tables++;
+    if (max_tables != 0 && finished_tables == max_tables)
+        all_finished = true;
+
+    return all_finished;
+}
+
+BUSYMessage TableDirectory::busy_message(std::optional<int> table_id)
+{
+    std::lock_guard<std::mutex> lock(mutex);
+
+    PositionList all_positions = {Position::North, Position::East, Position::South, Position::West};
+
+    auto it = table_id.has_value() ? tables.find(table_id.value()) : tables.begin();
+    if (it == tables.end() || it->second.game_ended)
+        return BUSYMessage(all_positions);
+
+    PositionList busy_positions;
+    for (auto position : all_positions)
+        if (it->second.taken.count(position) != 0)
+            busy_positions.push_back(position);
+
+    return BUSYMessage(busy_positions);
+}
+
+bool TableDirectory::can_end_server() const
+{
+    return all_finished;
+}
+
+/*
+ * Private functions
+ */
+
+void TableDirectory::create_table(int table_id)
+{
+    tables[table_id] = TableSeats{{}, false, false};
+    created_tables++;
+
+    for (auto &[position, seats] : open_seats)
+        seats.insert(table_id);
+}
+
+Lobby::Lobby(TableDirectory &directory, std::shared_ptr<const GameDefinition> definition, int timeout, bool auto_play)
+    : directory(directory)
+{
+    this->definition = definition;
+    this->timeout = timeout;
+    this->auto_play = auto_play;
+}
+
+std::optional<BUSYMessage> Lobby::join(std::shared_ptr<Socket> socket, Position position, int table_id)
+{
+    if (tables.find(table_id) == tables.end())
+        tables[table_id] = std::make_unique<ServerGameState>(definition, timeout, auto_play);
+
+    std::optional<BUSYMessage> busy = table(table_id).new_player(position, socket);
+    if (busy.has_value())
+        return busy;
+
+    socket_tables[socket] = table_id;
+
+    return std::nullopt;
+}
+
+std::optional<int> Lobby::find_table(const std::shared_ptr<Socket> &socket) const
+{
+    auto it = socket_tables.find(socket);
+    if (it == socket_tables.end())
+        return std::nullopt;
+    return it->second;
+}
+
+bool Lobby::has_table(int table_id) const
+{
+    return tables.find(table_id) != tables.end();
+}
+
+ServerGameState &Lobby::table(int table_id)
+{
+    return *tables.at(table_id);
+}
+
+void Lobby::continue_game(int table_id)
+{
+    ServerGameState &game_state = table(table_id);
+    bool game_ended = game_state.game_ended;
+
+    game_state.continue_game();
+
+    if (!game_ended && game_state.game_ended)
+        directory.end_game(table_id);
+}
+
+bool Lobby::disconnect_client(const std::shared_ptr<Socket> &socket)
+{
+    auto it = socket_tables.find(socket);
+    if (it == socket_tables.end())
+        return false;
+
+    int table_id = it->second;
+    socket_tables.erase(it);
+
+    ServerGameState &game_state = table(table_id);
+
+    bool abandoned = false;
+    for (auto &[position, player_socket] : game_state.player_sockets)
+        if (player_socket == socket)
+            abandoned = directory.release(table_id, position);
+
+    game_state.disconnect_client(socket);
+
+    if (abandoned)
+    {
+        tables.erase(table_id);
+        return false;
+    }
+
+    if (!game_state.can_end_server())
+        return false;
+
+    tables.erase(table_id);
+    return directory.remove(table_id);
+}
\ No newline at end of file
@@ -0,0 +1,188 @@
+#ifndef SERVER_LOBBY_H
+#define SERVER_LOBBY_H
+
+#include <atomic>
+#include <map>
+#include <mutex>
+#include <set>
+#include <unordered_map>
+
+#include "server-game-state.h"
+
+/**
+ * @brief Seats of all tables hosted by the server
+ *
+ * Clients are routed to a table by the table id in their IAM message, or to
+ * the first table with their seat free when there is none. The directory is
+ * shared by all shards and is used only when clients join or leave.
+ */
+class TableDirectory
+{
+private:
+    /**
+     * @brief Seats of a single table
+     */
+    struct TableSeats
+    {
+        std::set<Position> taken;
+        bool game_started;
+        bool game_ended;
+    };
+
+    std::mutex mutex;
+    int max_tables;
+    int created_tables;
+    int finished_tables;
+    int next_table_id;
+    std::atomic<bool> all_finished;
+
+    std::map<int, TableSeats> tables;
+    std::map<Position, std::set<int>> open_seats;
+
+public:
+    /**
+     * @brief Construct a new TableDirectory object
+     *
+     * @param max_tables Maximum number of tables, 0 means unlimited
+     */
+    TableDirectory(int max_tables);
+
+    /**
+     * @brief Reserve a seat, create the table if needed
+     *
+     * @param position The seat
+     * @param table_id Table chosen by the client, the first table with the seat free if not given
+     * @return std::optional<int> Id of the table, nothing if the seat could not be reserved
+     */
+    std::optional<int> reserve(Position position, std::optional<int> table_id);
+
+    /**
+     * @brief Free a reserved seat, remove the table if its game has not started and nobody sits at it
+     *
+     * A removed table no longer counts against the maximum number of tables.
+     *
+     * @param table_id Table id
+     * @param position The seat
+     * @return Whether the table was removed
+     */
+    bool release(int table_id, Position position);
+
+    /**
+     * @brief Close the table for new players once its game has ended
+     *
+     * @param table_id Table id
+     */
+    void end_game(int table_id);
+
+    /**
+     * @brief Remove a table whose game has ended and all players have left
+     *
+     * @param table_id Table id
+     * @return Whether all games of the server have been played
+     */
+    bool remove(int table_id);
+
+    /**
+     * @brief Build BUSY message for a client whose seat could not be reserved
+     *
+     * @param table_id Table chosen by the client
+     * @return BUSYMessage
+     */
+    BUSYMessage busy_message(std::optional<int> table_id);
+
+    /**
+     * @brief Cheks if server can be terminated.
+     *
+     * @return Can end server.
+     */
+    bool can_end_server() const;
+
+private:
+    /**
+     * @brief Create a new table
+     *
+     * @param table_id Table id
+     */
+    void create_table(int table_id);
+};
+
+/**
+ * @brief Tables hosted by a single shard
+ *
+ * Every table has its own ServerGameState, tables are created when the first
+ * client joins and removed once their game has ended and all players have left,
+ * or once all players have left before the game started.
+ */
+class Lobby
+{
+private:
+    TableDirectory &directory;
+    std::shared_ptr<const GameDefinition> definition;
+    int timeout;
+    bool auto_play;
+
+    std::map<int, std::unique_ptr<ServerGameState>> tables;
+    std::unordered_map<std::shared_ptr<Socket>, int> socket_tables;
+
+public:
+    /**
+     * @brief Construct a new Lobby object
+     *
+     * @param directory Seats of all tables
+     * @param definition Game definition played at every table
+     * @param timeout Timeout
+     * @param auto_play Whether tables play forced moves themselves
+     */
+    Lobby(TableDirectory &directory, std::shared_ptr<const GameDefinition> definition, int timeout, bool auto_play = false);
+
+    /**
+     * @brief Seat the client at a table
+     *
+     * @param socket Socket
+     * @param position The seat, reserved in the directory
+     * @param table_id Table id
+     * @return std::optional<BUSYMessage> BUSY message if the client could not be seated
+     */
+    std::optional<BUSYMessage> join(std::shared_ptr<Socket> socket, Position position, int table_id);
+
+    /**
+     * @brief Find the table of a client
+     *
+     * @param socket Socket
+     * @return std::optional<int> Table id
+     */
+    std::optional<int> find_table(const std::shared_ptr<Socket> &socket) const;
+
+    /**
+     * @brief Check if a table is hosted by the lobby
+     *
+     * @param table_id Table id
+     * @return Whether the table exists
+     */
+    bool has_table(int table_id) const;
+
+    /**
+     * @brief Get table
+     *
+     * @param table_id Table id
+     * @return ServerGameState& Game state of the table
+     */
+    ServerGameState &table(int table_id);
+
+    /**
+     * @brief Continue game at a table, send necessary messages, etc.
+     *
+     * @param table_id Table id
+     */
+    void continue_game(int table_id);
+
+    /**
+     * @brief Disconnect client from its table, remove the table if its game is over or nobody is left to start it
+     *
+     * @param socket Socket
+     * @return Whether all games of the server have been played
+     */
+    bool disconnect_client(const std::shared_ptr<Socket> &socket);
+};
+
+#endif // SERVER_LOBBY_H
\ No newline at end of file
@@ -0,0 +1,417 @@
+#include <sys/eventfd.h>
+#include <unistd.h>
+#include <string.h>
+#include <iostream>
+#include <algorithm>
+
+#include "server-shard.h"
+
+ServerShard::ServerShard(int shard_id, int shards_count, const std::vector<std::unique_ptr<ServerShard>> &shards,
+                         TableDirectory &directory, uint16_t port, std::shared_ptr<const GameDefinition> definition,
+                         const ShardOptions &options)
+    : shards(shards),
+      directory(directory),
+      options(options),
+      lobby(directory, definition, options.timeout, options.auto_play),
+      loop_stats(options.stats, shards_count == 1 ? "server" : "shard " + std::to_string(shard_id)),
+      timer_wheel(get_monotonic_time_in_millis())
+{
+    this->shard_id = shard_id;
+    this->shards_count = shards_count;
+
+    main_socket = std::make_unique<Socket>(port, true, shards_count > 1);
+
+    inbox_fd = eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+    if (inbox_fd == -1)
+        throw std::runtime_error(strerror(errno));
+
+    backend = IOBackend::create(options.backend);
+    backend->add_listener(*main_socket);
+    backend->add_inbox(inbox_fd);
+}
+
+ServerShard::~ServerShard()
+{
+    backend.reset();
+    close(inbox_fd);
+}
+
+uint16_t ServerShard::port() const
+{
+    return main_socket->local_port();
+}
+
+void ServerShard::run()
+{
+    int poll_timeout = -1;
+
+    while (!directory.can_end_server())
+    {
+        int events_count = backend->wait(poll_timeout);
+        loop_stats.wakeup();
+
+        for (int i = 0; i < events_count; i++)
+        {
+            const IOEvent &event = backend->event(i);
+
+            if (event.type == IOEventType::Accept)
+                accept_client(event.socket);
+            else if (event.type == IOEventType::Inbox)
+                handle_inbox();
+            else
+                handle_client_event(event);
+        }
+
+        // The clock is read once per wakeup, only sockets with an expired timer are visited.
+        long long now = get_monotonic_time_in_millis();
+        for (int socket_fd : timer_wheel.advance(now))
+        {
+            auto it = clients.find(socket_fd);
+            if (it == clients.end())
+                continue;
+
+            std::shared_ptr<Socket> client_socket = it->second;
+            loop_stats.handled(handle_messages(client_socket, client_socket->is_timed_out(now)));
+            touched_sockets.push_back(client_socket);
+        }
+
+        handle_resumed_sockets();
+        continue_tables();
+        flush_touched_sockets();
+
+        // Resumed clients and tables continue right away, they may not be touched by any event.
+        bool resumed = !resumed_sockets.empty() || !resumed_tables.empty();
+        poll_timeout = resumed ? 0 : timer_wheel.next_timeout(now);
+    }
+}
+
+void ServerShard::hand_off(std::shared_ptr<Socket> socket, Position position, int table_id)
+{
+    {
+        std::lock_guard<std::mutex> lock(inbox_mutex);
+        inbox.push_back(HandOff{socket, position, table_id});
+    }
+
+    wake_up();
+}
+
+void ServerShard::wake_up()
+{
+    uint64_t value = 1;
+    if (write(inbox_fd, &value, sizeof(value)) == -1 && errno != EAGAIN)
+        throw std::runtime_error(strerror(errno));
+}
+
+/*
+ * Private functions
+ */
+
+void ServerShard::accept_client(const std::shared_ptr<Socket> &client_socket)
+{
+    client_socket->await_message(MessageType::IAM, options.timeout);
+    register_client(client_socket);
+}
+
+void ServerShard::register_client(const std::shared_ptr<Socket> &socket)
+{
+    backend->add_client(socket);
+    clients[socket->socket_fd] = socket;
+
+    socket->timer.id = socket->socket_fd;
+    update_timer(socket);
+}
+
+void ServerShard::unregister_client(const std::shared_ptr<Socket> &socket)
+{
+    backend->remove_client(socket);
+    clients.erase(socket->socket_fd);
+    timer_wheel.cancel(socket->timer);
+}
+
+void ServerShard::handle_client_event(const IOEvent &event)
+{
+    std::shared_ptr<Socket> client_socket = event.socket;
+
+    if (event.hangup)
+        std::cerr << "Client disconnected\n";
+
+    loop_stats.handled(handle_messages(client_socket));
+    touched_sockets.push_back(client_socket);
+}
+
+void ServerShard::handle_inbox()
+{
+    uint64_t value;
+    if (read(inbox_fd, &value, sizeof(value)) == -1 && errno != EAGAIN)
+        throw std::runtime_error(strerror(errno));
+
+    std::vector<HandOff> hand_offs;
+    {
+        std::lock_guard<std::mutex> lock(inbox_mutex);
+        hand_offs.swap(inbox);
+    }
+
+    for (auto &hand_off : hand_offs)
+    {
+        register_client(hand_off.socket);
+        join(hand_off.socket, hand_off.position, hand_off.table_id);
+
+        loop_stats.handled(handle_messages(hand_off.socket));
+        touched_sockets.push_back(hand_off.socket);
+    }
+}
+
+int ServerShard::handle_messages(std::shared_ptr<Socket> client_socket, bool timed_out)
+{
+    int handled = 0;
+
+    while (true)
+    {
+        // Replies to a client over the high watermark wait until it reads its output.
+        if (client_socket->pending_output_bytes() > options.high_watermark)
+            break;
+
+        std::string_view message_str = client_socket->next_message();
+        if (message_str.empty())
+            break;
+
+        handled++;
+
+        try
+        {
+            AnyMessage message = parse_message(message_str, client_socket->binary);
+
+            bool handed_off = std::visit(Overloaded{
+                [&](const IAMMessage &iam_message) { return handle_iam_message(client_socket, iam_message); },
+                [&](const TRICKMessage &trick_message)
+                {
+                    handle_trick_message(client_socket, trick_message);
+                    return false;
+                },
+                [](const auto &) { return false; },
+            }, message);
+
+            // The rest of the messages is handled by the owner of the table, it releases this one.
+            if (handed_off)
+                return handled;
+        }
+        catch (std::invalid_argument &e)
+        {
+            std::cerr << "Invalid message: " << e.what() << '\n';
+        }
+
+        client_socket->release_message();
+    }
+
+    if(client_socket->awaited_message == MessageType::IAM && timed_out)
+    {
+        client_socket->closed = true;
+        client_socket->all_messages_received = true;
+    }
+
+    if(client_socket->awaited_message == MessageType::TRICK && timed_out && lobby.find_table(client_socket).has_value())
+    {
+        ServerGameState &game_state = lobby.table(lobby.find_table(client_socket).value());
+        if (game_state.find_position(client_socket).has_value())
+            game_state.send_trick_message(game_state.find_position(client_socket).value());
+    }
+
+    return handled;
+}
+
+void ServerShard::handle_resumed_sockets()
+{
+    std::vector<std::shared_ptr<Socket>> sockets;
+    sockets.swap(resumed_sockets);
+
+    for (auto &client_socket : sockets)
+    {
+        // Slow sockets are resumed on closing too.
+        auto it = clients.find(client_socket->socket_fd);
+        if (it == clients.end() || it->second != client_socket)
+            continue;
+
+        loop_stats.handled(handle_messages(client_socket));
+        touched_sockets.push_back(client_socket);
+    }
+}
+
+bool ServerShard::handle_iam_message(const std::shared_ptr<Socket> &client_socket, const IAMMessage &iam_message)
+{
+    // The client switches to binary frames right after its IAM, so does the server.
+    if (iam_message.binary)
+        client_socket->binary = true;
+
+    std::optional<int> table_id = lobby.find_table(client_socket);
+    if (!table_id.has_value())
+        table_id = iam_message.table_id;
+
+    std::optional<int> reserved_table_id = directory.reserve(iam_message.position, table_id);
+    if (!reserved_table_id.has_value())
+    {
+        client_socket->send(directory.busy_message(table_id));
+        client_socket->closed = true;
+        return false;
+    }
+
+    int owner = reserved_table_id.value() % shards_count;
+    if (owner != shard_id)
+    {
+        unregister_client(client_socket);
+        shards[owner]->hand_off(client_socket, iam_message.position, reserved_table_id.value());
+        return true;
+    }
+
+    join(client_socket, iam_message.position, reserved_table_id.value());
+    return false;
+}
+
+void ServerShard::handle_trick_message(const std::shared_ptr<Socket> &client_socket, const TRICKMessage &trick_message)
+{
+    std::optional<int> table_id = lobby.find_table(client_socket);
+    if (!table_id.has_value())
+        throw std::invalid_argument("Client is not seated at a table");
+
+    ServerGameState &game_state = lobby.table(table_id.value());
+    std::optional<WRONGMessage> wrong_message = game_state.handle_trick_message(client_socket, trick_message);
+    if (wrong_message.has_value())
+        client_socket->send(*wrong_message);
+}
+
+void ServerShard::join(const std::shared_ptr<Socket> &client_socket, Position position, int table_id)
+{
+    std::optional<BUSYMessage> busy_message = lobby.join(client_socket, position, table_id);
+    if (busy_message.has_value())
+    {
+        directory.release(table_id, position);
+        client_socket->send(*busy_message);
+        client_socket->closed = true;
+    }
+}
+
+void ServerShard::continue_tables()
+{
+    // Only tables of the touched sockets could have changed.
+    std::vector<int> touched_tables;
+    for (auto &client_socket : touched_sockets)
+    {
+        std::optional<int> table_id = lobby.find_table(client_socket);
+        if (table_id.has_value())
+            touched_tables.push_back(table_id.value());
+    }
+
+    touched_tables.insert(touched_tables.end(), resumed_tables.begin(), resumed_tables.end());
+    resumed_tables.clear();
+
+    std::sort(touched_tables.begin(), touched_tables.end());
+    touched_tables.erase(std::unique(touched_tables.begin(), touched_tables.end()), touched_tables.end());
+
+    for (int table_id : touched_tables)
+    {
+        // A resumed table may have been removed in the meantime.
+        if (paused_tables.count(table_id) > 0 || !lobby.has_table(table_id))
+            continue;
+
+        lobby.continue_game(table_id);
+
+        for (auto &[position, player_socket] : lobby.table(table_id).player_sockets)
+            if (player_socket != nullptr)
+                touched_sockets.push_back(player_socket);
+    }
+}
+
+void ServerShard::flush_touched_sockets()
+{
+    std::sort(touched_sockets.begin(), touched_sockets.end());
+    touched_sockets.erase(std::unique(touched_sockets.begin(), touched_sockets.end()), touched_sockets.end());
+
+    for (auto &client_socket : touched_sockets)
+    {
+        // Sockets handed off to other shards are no longer ours.
+        auto it = clients.find(client_socket->socket_fd);
+        if (it == clients.end() || it->second != client_socket)
+            continue;
+
+        backend->flush_client(client_socket);
+        check_output_limit(client_socket);
+
+        if (client_socket->closed && client_socket->all_messages_received && client_socket->all_messages_sent)
+        {
+            release_slow_socket(client_socket);
+            unregister_client(client_socket);
+
+            // The last table has finished, other shards are still waiting for events.
+            if (lobby.disconnect_client(client_socket))
+                for (auto &shard : shards)
+                    if (shard.get() != this)
+                        shard->wake_up();
+            continue;
+        }
+
+        update_timer(client_socket);
+    }
+
+    // Closed sockets are destroyed only when the last reference is gone.
+    touched_sockets.clear();
+}
+
+void ServerShard::check_output_limit(const std::shared_ptr<Socket> &socket)
+{
+    size_t queued = socket->pending_output_bytes();
+    loop_stats.queued(queued);
+
+    if (slow_sockets.count(socket) > 0)
+    {
+        if (queued <= options.low_watermark)
+            release_slow_socket(socket);
+        return;
+    }
+
+    if (queued <= options.high_watermark || socket->closed)
+        return;
+
+    loop_stats.slow_client();
+
+    if (options.slow_client_policy == SlowClientPolicy::Drop)
+    {
+        // The queued output is abandoned, the client leaves its table like one whose connection has failed.
+        std::cerr << "Slow client dropped\n";
+        socket->abandon();
+        return;
+    }
+
+    // Its own requests would keep adding replies, so nothing more is read from it either.
+    std::optional<int> table_id = lobby.find_table(socket);
+    slow_sockets[socket] = table_id;
+    backend->throttle_client(socket, true);
+
+    if (table_id.has_value())
+        paused_tables[table_id.value()]++;
+}
+
+void ServerShard::release_slow_socket(const std::shared_ptr<Socket> &socket)
+{
+    auto it = slow_sockets.find(socket);
+    if (it == slow_sockets.end())
+        return;
+
+    std::optional<int> table_id = it->second;
+    slow_sockets.erase(it);
+    backend->throttle_client(socket, false);
+    resumed_sockets.push_back(socket);
+
+    if (table_id.has_value() && --paused_tables[table_id.value()] == 0)
+    {
+        paused_tables.erase(table_id.value());
+        resumed_tables.push_back(table_id.value());
+    }
+}
+
+void ServerShard::update_timer(const std::shared_ptr<Socket> &socket)
+{
+    // Game states set the awaited message directly, the timer follows it whenever the socket is touched.
+    if (socket->awaited_message.has_value() && !socket->closed)
+        timer_wheel.schedule(socket->timer, socket->deadline);
+    else
+        timer_wheel.cancel(socket->timer);
+}
\ No newline at end of file
@@ -0,0 +1,241 @@
+#ifndef SERVER_SHARD_H
+#define SERVER_SHARD_H
+
+#include <mutex>
+#include <unordered_map>
+
+#include "io-backend.h"
+#include "network-common.h"
+#include "server-lobby.h"
+
+#define DEFAULT_HIGH_WATERMARK (64 * 1024)
+#define DEFAULT_LOW_WATERMARK (16 * 1024)
+
+/**
+ * @brief What to do with a client whose writing queue has grown over the high watermark
+ */
+enum class SlowClientPolicy
+{
+    Drop,
+    Pause,
+};
+
+/**
+ * @brief Settings shared by all shards
+ */
+struct ShardOptions
+{
+    int timeout;
+    bool stats;
+    bool auto_play;
+    BackendType backend;
+    size_t high_watermark;
+    size_t low_watermark;
+    SlowClientPolicy slow_client_policy;
+};
+
+/**
+ * @brief Client handed off to another shard, with the seat reserved for it
+ */
+struct HandOff
+{
+    std::shared_ptr<Socket> socket;
+    Position position;
+    int table_id;
+};
+
+/**
+ * @brief Server shard
+ *
+ * Every shard runs in its own thread with its own listener (SO_REUSEPORT),
+ * event loop and tables, so a table never crosses threads. Table ids are
+ * split between shards by their remainder modulo the number of shards.
+ * A client seated at a table of another shard is handed off to it. Shards
+ * synchronize only on hand offs and in the table directory.
+ *
+ * A client that does not read its output is dropped once its writing queue
+ * exceeds the high watermark, or it is throttled and its table is paused
+ * until the queue drains below the low watermark.
+ */
+class ServerShard
+{
+private:
+    int shard_id;
+    int shards_count;
+    const std::vector<std::unique_ptr<ServerShard>> &shards;
+    TableDirectory &directory;
+    ShardOptions options;
+
+    std::unique_ptr<Socket> main_socket;
+    std::unique_ptr<IOBackend> backend;
+    Lobby lobby;
+    LoopStats loop_stats;
+    TimerWheel timer_wheel;
+
+    std::unordered_map<int, std::shared_ptr<Socket>> clients;
+    std::vector<std::shared_ptr<Socket>> touched_sockets;
+
+    std::unordered_map<std::shared_ptr<Socket>, std::optional<int>> slow_sockets;
+    std::unordered_map<int, int> paused_tables;
+    std::vector<std::shared_ptr<Socket>> resumed_sockets;
+    std::vector<int> resumed_tables;
+
+    int inbox_fd;
+    std::mutex inbox_mutex;
+    std::vector<HandOff> inbox;
+
+public:
+    /**
+     * @brief Construct a new ServerShard object
+     *
+     * @param shard_id Shard id
+     * @param shards_count Number of shards
+     * @param shards All shards of the server
+     * @param directory Seats of all tables
+     * @param port Port number
+     * @param definition Game definition
+     * @param options Shard settings
+     */
+    ServerShard(int shard_id, int shards_count, const std::vector<std::unique_ptr<ServerShard>> &shards,
+                TableDirectory &directory, uint16_t port, std::shared_ptr<const GameDefinition> definition,
+                const ShardOptions &options);
+
+    /**
+     * @brief Destroy the ServerShard object
+     */
+    ~ServerShard();
+
+    /**
+     * @brief Get port number the shard listens on
+     *
+     * @return Port number
+     */
+    uint16_t port() const;
+
+    /**
+     * @brief Run the event loop until all games of the server have been played
+     */
+    void run();
+
+    /**
+     * @brief Pass a client to this shard, may be called from any thread
+     *
+     * @param socket Socket
+     * @param position Seat reserved for the client
+     * @param table_id Table id
+     */
+    void hand_off(std::shared_ptr<Socket> socket, Position position, int table_id);
+
+    /**
+     * @brief Wake up the event loop, may be called from any thread
+     */
+    void wake_up();
+
+private:
+    /**
+     * @brief Accept a new client
+     *
+     * @param client_socket Socket of the accepted connection
+     */
+    void accept_client(const std::shared_ptr<Socket> &client_socket);
+
+    /**
+     * @brief Register client socket in the event loop
+     *
+     * @param socket Socket
+     */
+    void register_client(const std::shared_ptr<Socket> &socket);
+
+    /**
+     * @brief Unregister client socket from the event loop
+     *
+     * @param socket Socket
+     */
+    void unregister_client(const std::shared_ptr<Socket> &socket);
+
+    /**
+     * @brief Handle event of a client socket
+     *
+     * @param event Event
+     */
+    void handle_client_event(const IOEvent &event);
+
+    /**
+     * @brief Take over clients handed off by other shards
+     */
+    void handle_inbox();
+
+    /**
+     * @brief Handle received messages and timeouts of a client
+     *
+     * @param client_socket Socket
+     * @param timed_out Whether the awaited message has timed out
+     * @return Number of handled messages
+     */
+    int handle_messages(std::shared_ptr<Socket> client_socket, bool timed_out = false);
+
+    /**
+     * @brief Reserve the seat asked for by a client and seat it, or hand it off to the owner of the table
+     *
+     * @param client_socket Socket
+     * @param iam_message IAM message
+     * @return Whether the client was handed off to another shard
+     */
+    bool handle_iam_message(const std::shared_ptr<Socket> &client_socket, const IAMMessage &iam_message);
+
+    /**
+     * @brief Play the card of a seated client
+     *
+     * @param client_socket Socket
+     * @param trick_message TRICK message
+     */
+    void handle_trick_message(const std::shared_ptr<Socket> &client_socket, const TRICKMessage &trick_message);
+
+    /**
+     * @brief Handle messages held back while the resumed clients were throttled
+     */
+    void handle_resumed_sockets();
+
+    /**
+     * @brief Seat client at a table of this shard
+     *
+     * @param client_socket Socket
+     * @param position Seat reserved for the client
+     * @param table_id Table id
+     */
+    void join(const std::shared_ptr<Socket> &client_socket, Position position, int table_id);
+
+    /**
+     * @brief Continue games at tables of the touched sockets and at resumed tables, except paused ones
+     */
+    void continue_tables();
+
+    /**
+     * @brief Write output of the touched sockets, close finished ones
+     */
+    void flush_touched_sockets();
+
+    /**
+     * @brief Apply the slow client policy if the writing queue of a socket is over the high watermark,
+     * resume its table once the queue is below the low watermark
+     *
+     * @param socket Socket
+     */
+    void check_output_limit(const std::shared_ptr<Socket> &socket);
+
+    /**
+     * @brief Resume a slow socket and its table if no other slow socket holds it
+     *
+     * @param socket Socket
+     */
+    void release_slow_socket(const std::shared_ptr<Socket> &socket);
+
+    /**
+     * @brief Arm the timer of a socket awaiting a message, cancel it otherwise
+     *
+     * @param socket Socket
+     */
+    void update_timer(const std::shared_ptr<Socket> &socket);
+};
+
+#endif // SERVER_SHARD_H
\ No newline at end of file
@@ -0,0 +1,293 @@
+#include <benchmark/benchmark.h>
+#include <atomic>
+#include <cstddef>
+#include <cstdlib>
+#include <new>
+#include <string>
+
+#include "common.h"
+
+/*
+ * Allocation counting, every allocation of the process goes through the replaced operators new,
+ * plain, array, aligned and nothrow forms alike
+ */
+
+static std::atomic<size_t> allocations{0};
+
+/**
+ * @brief Count an allocation and get the memory from malloc
+ *
+ * @param size Number of bytes
+ * @param alignment Alignment, 0 for the default one
+ * @return Memory, nullptr if it could not be allocated
+ */
+static void *counted_alloc(size_t size, size_t alignment = 0)
+{
+    allocations.fetch_add(1, std::memory_order_relaxed);
+    if (size == 0)
+        size = 1;
+
+    if (alignment <= alignof(std::max_align_t))
+        return malloc(size);
+
+    void *ptr;
+    return posix_memalign(&ptr, alignment, size) == 0 ? ptr : nullptr;
+}
+
+/**
+ * @brief Allocate counted memory or throw like operator new
+ *
+ * @param size Number of bytes
+ * @param alignment Alignment, 0 for the default one
+ * @return Memory
+ */
+static void *counted_alloc_or_throw(size_t size, size_t alignment = 0)
+{
+    void *ptr = counted_alloc(size, alignment);
+    if (ptr == nullptr)
+        throw std::bad_alloc();
+    return ptr;
+}
+
+// Kept out of line, once inlined into a delete expression GCC would see free called on memory from new.
+__attribute__((noinline)) static void counted_free(void *ptr) noexcept
+{
+    free(ptr);
+}
+
+void *operator new(size_t size) { return counted_alloc_or_throw(size); }
+void *operator new[](size_t size) { return counted_alloc_or_throw(size); }
+void *operator new(size_t size, std::align_val_t alignment) { return counted_alloc_or_throw(size, static_cast<size_t>(alignment)); }
+void *operator new[](size_t size, std::align_val_t alignment) { return counted_alloc_or_throw(size, static_cast<size_t>(alignment)); }
+void *operator new(size_t size, const std::nothrow_t &) noexcept { return counted_alloc(size); }
+void *operator new[](size_t size, const std::nothrow_t &) noexcept { return counted_alloc(size); }
+void *operator new(size_t size, std::align_val_t alignment, const std::nothrow_t &) noexcept { return counted_alloc(size, static_cast<size_t>(alignment)); }
+void *operator new[](size_t size, std::align_val_t alignment, const std::nothrow_t &) noexcept { return counted_alloc(size, static_cast<size_t>(alignment)); }
+
+void operator delete(void *ptr) noexcept { counted_free(ptr); }
+void operator delete[](void *ptr) noexcept { counted_free(ptr); }
+void operator delete(void *ptr, size_t) noexcept { counted_free(ptr); }
+void operator delete[](void *ptr, size_t) noexcept { counted_free(ptr); }
+void operator delete(void *ptr, std::align_val_t) noexcept { counted_free(ptr); }
+void operator delete[](void *ptr, std::align_val_t) noexcept { counted_free(ptr); }
+void operator delete(void *ptr, size_t, std::align_val_t) noexcept { counted_free(ptr); }
+void operator delete[](void *ptr, size_t, std::align_val_t) noexcept { counted_free(ptr); }
+void operator delete(void *ptr, const std::nothrow_t &) noexcept { counted_free(ptr); }
+void operator delete[](void *ptr, const std::nothrow_t &) noexcept { counted_free(ptr); }
+void operator delete(void *ptr, std::align_val_t, const std::nothrow_t &) noexcept { counted_free(ptr); }
+void operator delete[](void *ptr, std::align_val_t, const std::nothrow_t &) noexcept { counted_free(ptr); }
+
+/**
+ * @brief Run the benchmark loop and report allocations per operation next to the time
+ *
+ * @param state Benchmark state
+ * @param operation Operation to be measured
+ */
+template <typename F>
+static void run_counted(benchmark::State &state, F operation)
+{
+    size_t before = allocations.load(std::memory_order_relaxed);
+    for (auto _ : state)
+        operation();
+    size_t after = allocations.load(std::memory_order_relaxed);
+
+    state.counters["allocs/op"] = benchmark::Counter(after - before, benchmark::Counter::kAvgIterations);
+}
+
+/*
+ * Inputs
+ */
+
+static Scores make_scores()
+{
+    Scores scores;
+    scores[Position::North] = 13;
+    scores[Position::East] = 0;
+    scores[Position::South] = 1042;
+    scores[Position::West] = 7;
+    return scores;
+}
+
+static const Scores SCORES = make_scores();
+
+static const CardList HAND = Card::parse_cards("2C3C4C5C6C7C8C9C10CJCQCKCAC");
+
+static const CardList TRICK = Card::parse_cards("10HQSAD");
+
+static const CardList TAKEN_CARDS = Card::parse_cards("10HQSAD2C");
+
+/**
+ * @brief Serialize message into a binary frame
+ *
+ * @param message Message
+ * @return Frame
+ */
+static std::string binary_frame(const Message &message)
+{
+    std::string frame(message.binary_size(), '\0');
+    message.serialize_binary_into(frame.data());
+    return frame;
+}
+
+/*
+ * Parsing
+ */
+
+static void BM_ParseMessage(benchmark::State &state, std::string message, bool binary = false)
+{
+    run_counted(state, [&]()
+    {
+        try
+        {
+            benchmark::DoNotOptimize(parse_message(message, binary));
+        }
+        catch (const std::invalid_argument &)
+        {
+        }
+    });
+}
+
+BENCHMARK_CAPTURE(BM_ParseMessage, IAM, std::string("IAMN\r\n"));
+BENCHMARK_CAPTURE(BM_ParseMessage, IAMTable, std::string("IAMN123456B\r\n"));
+BENCHMARK_CAPTURE(BM_ParseMessage, BUSY, std::string("BUSYNESW\r\n"));
+BENCHMARK_CAPTURE(BM_ParseMessage, DEAL, std::string("DEAL3S2C3C4C5C6C7C8C9C10CJCQCKCAC\r\n"));
+BENCHMARK_CAPTURE(BM_ParseMessage, TRICKEmpty, std::string("TRICK1\r\n"));
+BENCHMARK_CAPTURE(BM_ParseMessage, TRICK, std::string("TRICK1210HQSAD\r\n"));
+BENCHMARK_CAPTURE(BM_ParseMessage, WRONG, std::string("WRONG12\r\n"));
+BENCHMARK_CAPTURE(BM_ParseMessage, TAKEN, std::string("TAKEN1310HQSAD2CW\r\n"));
+BENCHMARK_CAPTURE(BM_ParseMessage, SCORE, std::string("SCOREN13E0S1042W7\r\n"));
+BENCHMARK_CAPTURE(BM_ParseMessage, TOTAL, std::string("TOTALN13E0S1042W7\r\n"));
+BENCHMARK_CAPTURE(BM_ParseMessage, BinaryTRICK, binary_frame(TRICKMessage(12, TRICK)), true);
+BENCHMARK_CAPTURE(BM_ParseMessage, BinarySCORE, binary_frame(SCOREMessage(SCORES)), true);
+BENCHMARK_CAPTURE(BM_ParseMessage, MalformedHeader, std::string("HELLO\r\n"));
+BENCHMARK_CAPTURE(BM_ParseMessage, MalformedTerminator, std::string("TRICK1210HQSAD\n"));
+BENCHMARK_CAPTURE(BM_ParseMessage, MalformedCard, std::string("TRICK1210HQXAD\r\n"));
+BENCHMARK_CAPTURE(BM_ParseMessage, DuplicateCards, std::string("TAKEN1310HQS10H2CW\r\n"));
+BENCHMARK_CAPTURE(BM_ParseMessage, MalformedSCORE, std::string("SCOREN13E0S1042N7\r\n"));
+BENCHMARK_CAPTURE(BM_ParseMessage, MalformedBinary, std::string("\x05\x03\x01", 3), true);
+
+static void BM_MessageFromString(benchmark::State &state, std::string message)
+{
+    run_counted(state, [&]() { benchmark::DoNotOptimize(Message::from_string(message)); });
+}
+
+BENCHMARK_CAPTURE(BM_MessageFromString, TRICK, std::string("TRICK1210HQSAD\r\n"));
+BENCHMARK_CAPTURE(BM_MessageFromString, SCORE, std::string("SCOREN13E0S1042W7\r\n"));
+
+static void BM_ParseCards(benchmark::State &state, std::string card_list)
+{
+    run_counted(state, [&]() { benchmark::DoNotOptimize(Card::parse_cards(card_list)); });
+}
+
+BENCHMARK_CAPTURE(BM_ParseCards, 0, std::string(""));
+BENCHMARK_CAPTURE(BM_ParseCards, 3, std::string("10HQSAD"));
+BENCHMARK_CAPTURE(BM_ParseCards, 4, std::string("10HQSAD2C"));
+BENCHMARK_CAPTURE(BM_ParseCards, 13, std::string("2C3C4C5C6C7C8C9C10CJCQCKCAC"));
+
+/*
+ * Serialization
+ */
+
+static void BM_ToString(benchmark::State &state, const Message &message)
+{
+    run_counted(state, [&]() { benchmark::DoNotOptimize(message.to_string()); });
+}
+
+static void BM_SerializeInto(benchmark::State &state, const Message &message)
+{
+    char buffer[MAX_CARDS_IN_LIST * 3 + 64];
+    run_counted(state, [&]()
+    {
+        message.serialize_into(buffer);
+        benchmark::DoNotOptimize(buffer);
+    });
+}
+
+static void BM_SerializeBinaryInto(benchmark::State &state, const Message &message)
+{
+    char buffer[MAX_BINARY_FRAME_SIZE];
+    run_counted(state, [&]()
+    {
+        message.serialize_binary_into(buffer);
+        benchmark::DoNotOptimize(buffer);
+    });
+}
+
+static const IAMMessage IAM(Position::North, 123456);
+static const BUSYMessage BUSY({Position::North, Position::East, Position::South, Position::West});
+static const DEALMessage DEAL(DealType::QUEEN, Position::South, HAND);
+static const TRICKMessage TRICK_MESSAGE(12, TRICK);
+static const WRONGMessage WRONG(12);
+static const TAKENMessage TAKEN(13, TAKEN_CARDS, Position::West);
+static const SCOREMessage SCORE(SCORES);
+static const TOTALMessage TOTAL(SCORES);
+
+#define BENCHMARK_SERIALIZERS(name, message)                      \
+    BENCHMARK_CAPTURE(BM_ToString, name, message);                \
+    BENCHMARK_CAPTURE(BM_SerializeInto, name, message);           \
+    BENCHMARK_CAPTURE(BM_SerializeBinaryInto, name, message)
+
+BENCHMARK_SERIALIZERS(IAM, IAM);
+BENCHMARK_SERIALIZERS(BUSY, BUSY);
+BENCHMARK_SERIALIZERS(DEAL, DEAL);
+BENCHMARK_SERIALIZERS(TRICK, TRICK_MESSAGE);
+BENCHMARK_SERIALIZERS(WRONG, WRONG);
+BENCHMARK_SERIALIZERS(TAKEN, TAKEN);
+BENCHMARK_SERIALIZERS(SCORE, SCORE);
+BENCHMARK_SERIALIZERS(TOTAL, TOTAL);
+
+/*
+ * Enum conversions
+ */
+
+static void BM_MessageTypeFromString(benchmark::State &state)
+{
+    std::string header = "TAKEN";
+    run_counted(state, [&]() { benchmark::DoNotOptimize(from_string<MessageType>(header)); });
+}
+BENCHMARK(BM_MessageTypeFromString);
+
+static void BM_MessageTypeFromHeader(benchmark::State &state)
+{
+    std::string_view header = "TAKEN";
+    benchmark::DoNotOptimize(header);
+    run_counted(state, [&]() { benchmark::DoNotOptimize(message_type_from_header(header)); });
+}
+BENCHMARK(BM_MessageTypeFromHeader);
+
+static void BM_MessageTypeToString(benchmark::State &state)
+{
+    MessageType type = MessageType::TOTAL;
+    benchmark::DoNotOptimize(type);
+    run_counted(state, [&]() { benchmark::DoNotOptimize(to_string<MessageType>(type)); });
+}
+BENCHMARK(BM_MessageTypeToString);
+
+static void BM_PositionFromString(benchmark::State &state)
+{
+    std::string letter = "W";
+    run_counted(state, [&]() { benchmark::DoNotOptimize(from_string<Position>(letter)); });
+}
+BENCHMARK(BM_PositionFromString);
+
+static void BM_PositionToString(benchmark::State &state)
+{
+    Position position = Position::West;
+    benchmark::DoNotOptimize(position);
+    run_counted(state, [&]() { benchmark::DoNotOptimize(to_string<Position>(position)); });
+}
+BENCHMARK(BM_PositionToString);
+
+static void BM_ColorFromString(benchmark::State &state)
+{
+    std::string letter = "S";
+    run_counted(state, [&]() { benchmark::DoNotOptimize(from_string<Color>(letter)); });
+}
+BENCHMARK(BM_ColorFromString);
+
+static void BM_DealTypeFromString(benchmark::State &state)
+{
+    std::string digit = "7";
+    run_counted(state, [&]() { benchmark::DoNotOptimize(from_string<DealType>(digit)); });
+}
+BENCHMARK(BM_DealTypeFromString);
\ No newline at end of file
@@ -1,5 +1,6 @@
 #include <gtest/gtest.h>
 #include <string>
+#include <type_traits>
 
 #include "common.h"
 #include "common_test.h"
@@ -64,6 +65,35 @@ TEST(CommonTest, StringToPosition)
 }
 
 // Define a test
+TEST(CommonTest, StringToDealType)
+{
+    ASSERT_EQ(to_string<DealType>(DealType::TRICK), "1");
+    ASSERT_EQ(to_string<DealType>(DealType::BANDIT), "7");
+    ASSERT_EQ(from_string<DealType>("1"), DealType::TRICK);
+    ASSERT_EQ(from_string<DealType>("7"), DealType::BANDIT);
+    ASSERT_THROW(from_string<DealType>("0"), std::invalid_argument);
+    ASSERT_THROW(from_string<DealType>("8"), std::invalid_argument);
+    ASSERT_THROW(from_string<DealType>("1x"), std::invalid_argument);
+}
+
+TEST(CommonTest, ConstexprConversions)
+{
+    static_assert(message_type_header(MessageType::TAKEN) == "TAKEN");
+    static_assert(message_type_from_header("TOTAL") == MessageType::TOTAL);
+    static_assert(message_type_from_header("TRICK") == MessageType::TRICK);
+    static_assert(!message_type_from_header("TAKE").has_value());
+    static_assert(!message_type_from_header("TOTALS").has_value());
+    static_assert(position_from_letter(position_letter(Position::West)) == Position::West);
+    static_assert(!position_from_letter('X').has_value());
+    static_assert(color_from_letter('S') == Color::Spades);
+    static_assert(deal_type_digit(DealType::KING_HEART) == '5');
+    static_assert(deal_type_from_digit('3') == DealType::QUEEN);
+    static_assert(!deal_type_from_digit('0').has_value());
+
+    for (size_t i = 0; i < std::size(MESSAGE_TYPE_HEADERS); i++)
+        ASSERT_EQ(message_type_from_header(MESSAGE_TYPE_HEADERS[i]), static_cast<MessageType>(i));
+}
+
 TEST(CardSuite, ConstructorThrows)
 {
     // Assert
@@ -75,8 +105,27 @@ TEST(CardSuite, Constructor)
     // Arrange
     Card card("AS");
     // Assert
-    ASSERT_EQ(card.figure, "A");
-    ASSERT_EQ(card.color, Color::Spades);
+    ASSERT_EQ(card.figure(), "A");
+    ASSERT_EQ(card.color(), Color::Spades);
+}
+
+TEST(CardSuite, ParseConstexpr)
+{
+    // Arrange
+    constexpr Card ten_of_hearts = Card::parse("10H");
+    constexpr Card two_of_clubs = Card::parse("2C");
+    constexpr Card ace_of_spades = Card::parse("AS");
+    // Assert
+    static_assert(sizeof(Card) == 1);
+    static_assert(std::is_trivially_copyable_v<Card>);
+    static_assert(two_of_clubs.id() == 0);
+    static_assert(ace_of_spades.id() == CARDS_IN_DECK - 1);
+    static_assert(ten_of_hearts.value() == 10 && ten_of_hearts.color() == Color::Hearts);
+    ASSERT_EQ(ten_of_hearts.figure(), "10");
+    ASSERT_EQ(Card("10H"), ten_of_hearts);
+    ASSERT_THROW(Card::parse("1H"), std::invalid_argument);
+    ASSERT_THROW(Card::parse("1XH"), std::invalid_argument);
+    ASSERT_THROW(Card::parse("AX"), std::invalid_argument);
 }
 
 TEST(CardSuite, Compare1)
@@ -102,15 +151,15 @@ TEST(CardSuite, ParseCards)
     // Arrange
     std::string card_list = "ASKH10D";
     // Act
-    std::vector<Card> cards = Card::parse_cards(card_list);
+    CardList cards = Card::parse_cards(card_list);
     // Assert
     ASSERT_EQ(cards.size(), 3);
-    ASSERT_EQ(cards[0].figure, "A");
-    ASSERT_EQ(cards[0].color, Color::Spades);
-    ASSERT_EQ(cards[1].figure, "K");
-    ASSERT_EQ(cards[1].color, Color::Hearts);
-    ASSERT_EQ(cards[2].figure, "10");
-    ASSERT_EQ(cards[2].color, Color::Diamonds);
+    ASSERT_EQ(cards[0].figure(), "A");
+    ASSERT_EQ(cards[0].color(), Color::Spades);
+    ASSERT_EQ(cards[1].figure(), "K");
+    ASSERT_EQ(cards[1].color(), Color::Hearts);
+    ASSERT_EQ(cards[2].figure(), "10");
+    ASSERT_EQ(cards[2].color(), Color::Diamonds);
 }
 
 TEST(CardSuite, ToString)
@@ -128,7 +177,7 @@ TEST(CardSuite, ParseCardsEmpty)
     // Arrange
     std::string card_list = "";
     // Act
-    std::vector<Card> cards = Card::parse_cards(card_list);
+    CardList cards = Card::parse_cards(card_list);
     // Assert
     ASSERT_EQ(cards.size(), 0);
 }
@@ -143,19 +192,50 @@ TEST(CardSuite, ParseCardsThrows)
     ASSERT_THROW(Card::parse_cards(card_list2), std::invalid_argument);
 }
 
+TEST(CardSuite, ParseCardsDuplicatesAndLength)
+{
+    // Arrange
+    std::string duplicates = "AS10DAS";
+    std::string too_many = "2C3C4C5C6C7C8C9C10CJCQCKCAC2D";
+    std::string full_suit = "2C3C4C5C6C7C8C9C10CJCQCKCAC";
+    // Act
+    CardList cards = Card::parse_cards(full_suit);
+    // Assert
+    ASSERT_THROW(Card::parse_cards(duplicates), std::invalid_argument);
+    ASSERT_THROW(Card::parse_cards(too_many), std::invalid_argument);
+    ASSERT_EQ(cards.size(), 13);
+    ASSERT_EQ(cards[8].figure(), "10");
+    ASSERT_EQ(cards[12].figure(), "A");
+    ASSERT_EQ(cards[12].color(), Color::Clubs);
+}
+
+TEST(CardSuite, CardMask)
+{
+    CardList hand = Card::parse_cards("2C10HQHAS");
+
+    CardMask mask = cards_to_mask(hand);
+
+    ASSERT_EQ(__builtin_popcountll(mask), 4);
+    ASSERT_NE(mask & card_mask(Card("10H")), 0);
+    ASSERT_EQ(mask & card_mask(Card("10D")), 0);
+    ASSERT_EQ(__builtin_popcountll(mask & color_mask(Color::Hearts)), 2);
+    ASSERT_EQ(mask & color_mask(Color::Diamonds), 0);
+    static_assert((color_mask(Color::Clubs) | color_mask(Color::Diamonds) | color_mask(Color::Hearts) | color_mask(Color::Spades)) == (CardMask{1} << CARDS_IN_DECK) - 1);
+    static_assert(card_mask(Card::parse("AS")) == CardMask{1} << (CARDS_IN_DECK - 1));
+}
+
 TEST(MessageSuite, Constructor)
 {
     // Arrange
-    Message message(MessageType::IAM, "N");
+    IAMMessage message(Position::North);
     // Assert
     ASSERT_EQ(message.type, MessageType::IAM);
-    ASSERT_EQ(message.data, "N");
 }
 
 TEST(MessageSuite, ToString)
 {
     // Arrange
-    Message message(MessageType::IAM, "N");
+    IAMMessage message(Position::North);
     // Act
     std::string message_str = message.to_string();
     // Assert
@@ -173,7 +253,88 @@ TEST(MessageSuite, FromString)
     ASSERT_THROW(Message::from_string(message_str2), std::invalid_argument);
     // Assert
     ASSERT_EQ(message1->type, MessageType::IAM);
-    ASSERT_EQ(message1->data, "N");
+    ASSERT_EQ(message1->to_string(), message_str1);
+}
+
+TEST(MessageSuite, FromStringHeader)
+{
+    // Arrange
+    std::string message_str1 = "XIAMN\r\n";
+    std::string message_str2 = "TRICX1\r\n";
+    std::string message_str3 = "TOTAN1E2S3W4\r\n";
+    // Act & Assert
+    ASSERT_THROW(Message::from_string(message_str1), std::invalid_argument);
+    ASSERT_THROW(Message::from_string(message_str2), std::invalid_argument);
+    ASSERT_THROW(Message::from_string(message_str3), std::invalid_argument);
+}
+
+TEST(MessageSuite, SerializeInto)
+{
+    // Arrange
+    TAKENMessage taken_message(10, Card::parse_cards("10HJH2HAH"), Position::East);
+    SCOREMessage score_message({{Position::North, 0}, {Position::East, 123}, {Position::South, 7}, {Position::West, 40}});
+    IAMMessage iam_message(Position::South, 1000);
+    // Act
+    std::string buffer(taken_message.serialized_size() + score_message.serialized_size() + iam_message.serialized_size(), '#');
+    taken_message.serialize_into(buffer.data());
+    score_message.serialize_into(buffer.data() + taken_message.serialized_size());
+    iam_message.serialize_into(buffer.data() + taken_message.serialized_size() + score_message.serialized_size());
+    // Assert
+    ASSERT_EQ(buffer, "TAKEN1010HJH2HAHE\r\nSCOREN0E123S7W40\r\nIAMS1000\r\n");
+}
+
+TEST(MessageSuite, BinaryFrames)
+{
+    // Arrange
+    std::vector<std::string> texts = {"IAMN42B\r\n", "BUSYNS\r\n", "DEAL3W2C3C4C5C6C7C8C9C10CJCQCKCAC\r\n", "TRICK1010HAS\r\n",
+                                      "WRONG13\r\n", "TAKEN22C3C4C5CE\r\n", "SCOREN1E20S300W4000\r\n", "TOTALN0E0S0W130\r\n"};
+    std::vector<std::string> frames;
+    // Act
+    for (const std::string &text : texts)
+    {
+        AnyMessage message = parse_message(text);
+        const Message &base = std::visit([](const auto &alternative) -> const Message & { return alternative; }, message);
+        std::string frame(base.binary_size(), '\0');
+        base.serialize_binary_into(frame.data());
+        frames.push_back(frame);
+    }
+    // Assert
+    ASSERT_EQ(frames[1], std::string("\x04\x01NS", 4));
+    ASSERT_EQ(frames[3], std::string("\x05\x03\x0a\x22\x33", 5));
+    for (size_t i = 0; i < texts.size(); i++)
+    {
+        ASSERT_TRUE(is_binary_frame(frames[i][0]));
+        ASSERT_TRUE(is_binary_frame_length(frames[i][0]));
+        ASSERT_LE(frames[i].size(), MAX_BINARY_FRAME_SIZE);
+        AnyMessage decoded = parse_message(frames[i], true);
+        std::string text = std::visit([](const auto &alternative) { return alternative.to_string(); }, decoded);
+        ASSERT_EQ(text, i == 0 ? "IAMN42B\r\n" : texts[i]);
+    }
+    ASSERT_THROW(parse_message(std::string("\x04\x03\x01\x34", 4), true), std::invalid_argument);
+    ASSERT_THROW(parse_message(std::string("\x05\x03\x01\x00\x00", 5), true), std::invalid_argument);
+    ASSERT_THROW(parse_message(std::string("\x03\x09\x01", 3), true), std::invalid_argument);
+
+    // Messages in the format that was not negotiated are rejected.
+    ASSERT_THROW(parse_message(frames[1]), std::invalid_argument);
+    ASSERT_THROW(parse_message(texts[1], true), std::invalid_argument);
+}
+
+TEST(MessageSuite, ParseMessage)
+{
+    // Arrange
+    std::string message_str1 = "TAKEN12C3C4C5CN\r\n";
+    std::string message_str2 = "IAMW\r\n";
+    // Act
+    AnyMessage message1 = parse_message(message_str1);
+    AnyMessage message2 = parse_message(message_str2);
+    // Assert
+    ASSERT_TRUE(std::holds_alternative<TAKENMessage>(message1));
+    ASSERT_EQ(std::get<TAKENMessage>(message1).trick_number, 1);
+    ASSERT_EQ(std::get<TAKENMessage>(message1).cards.size(), 4);
+    ASSERT_EQ(std::get<TAKENMessage>(message1).taken_by, Position::North);
+    ASSERT_TRUE(std::holds_alternative<IAMMessage>(message2));
+    ASSERT_EQ(std::get<IAMMessage>(message2).position, Position::West);
+    ASSERT_THROW(parse_message("BUSY\r"), std::invalid_argument);
 }
 
 TEST(IAMMessageSuite, Constructor)
@@ -215,6 +376,28 @@ TEST(IAMMessageSuite, FromString)
     }
 }
 
+TEST(IAMMessageSuite, TableId)
+{
+    // Arrange
+    IAMMessage message(Position::East, 42);
+    std::string message_str1 = "IAMS7\r\n";
+    std::string message_str2 = "IAMS07\r\n";
+    std::string message_str3 = "IAMS1234567890\r\n";
+    // Act
+    std::shared_ptr<Message> message_ptr1 = Message::from_string(message_str1);
+    ASSERT_THROW(Message::from_string(message_str2), std::invalid_argument);
+    ASSERT_THROW(Message::from_string(message_str3), std::invalid_argument);
+    // Assert
+    ASSERT_EQ(message.to_string(), "IAME42\r\n");
+    std::shared_ptr<IAMMessage> iam_message_ptr1 = std::dynamic_pointer_cast<IAMMessage>(message_ptr1);
+    ASSERT_NE(iam_message_ptr1, nullptr);
+    if (iam_message_ptr1 != nullptr)
+    {
+        ASSERT_EQ(iam_message_ptr1->position, Position::South);
+        ASSERT_EQ(iam_message_ptr1->table_id, 7);
+    }
+}
+
 TEST(BUSYMessageSuite, Constructor)
 {
     // Arrange
@@ -285,8 +468,8 @@ TEST(DEALMessageSuite, Constructor)
     ASSERT_EQ(message.cards.size(), 13);
     for (int i = 0; i < 13; ++i)
     {
-        ASSERT_EQ(message.cards[i].figure, cards[i].figure);
-        ASSERT_EQ(message.cards[i].color, Color::Spades);
+        ASSERT_EQ(message.cards[i].figure(), cards[i].figure());
+        ASSERT_EQ(message.cards[i].color(), Color::Spades);
     }
 }
 
@@ -331,8 +514,8 @@ TEST(DEALMessageSuite, FromString)
         std::vector<std::string> figures = {"A", "2", "3", "4", "5", "6", "7", "8", "9", "10", "J", "Q", "K"};
         for (int i = 0; i < 13; ++i)
         {
-            ASSERT_EQ(valid_deal_message_ptr->cards[i].figure, figures[i]);
-            ASSERT_EQ(valid_deal_message_ptr->cards[i].color, Color::Spades);
+            ASSERT_EQ(valid_deal_message_ptr->cards[i].figure(), figures[i]);
+            ASSERT_EQ(valid_deal_message_ptr->cards[i].color(), Color::Spades);
         }
     }
 }
@@ -349,8 +532,8 @@ TEST(TRICKMessageSuite, Constructor)
     ASSERT_EQ(message1.cards.size(), cards.size());
     for (size_t i = 0; i < cards.size(); ++i)
     {
-        ASSERT_EQ(message1.cards[i].figure, cards[i].figure);
-        ASSERT_EQ(message1.cards[i].color, cards[i].color);
+        ASSERT_EQ(message1.cards[i].figure(), cards[i].figure());
+        ASSERT_EQ(message1.cards[i].color(), cards[i].color());
     }
 
     // Arrange
@@ -405,12 +588,12 @@ TEST(TRICKMessageSuite, FromString)
     {
         ASSERT_EQ(trick_message_ptr1->trick_number, 1);
         ASSERT_EQ(trick_message_ptr1->cards.size(), 3);
-        ASSERT_EQ(trick_message_ptr1->cards[0].figure, "A");
-        ASSERT_EQ(trick_message_ptr1->cards[0].color, Color::Spades);
-        ASSERT_EQ(trick_message_ptr1->cards[1].figure, "K");
-        ASSERT_EQ(trick_message_ptr1->cards[1].color, Color::Hearts);
-        ASSERT_EQ(trick_message_ptr1->cards[2].figure, "10");
-        ASSERT_EQ(trick_message_ptr1->cards[2].color, Color::Diamonds);
+        ASSERT_EQ(trick_message_ptr1->cards[0].figure(), "A");
+        ASSERT_EQ(trick_message_ptr1->cards[0].color(), Color::Spades);
+        ASSERT_EQ(trick_message_ptr1->cards[1].figure(), "K");
+        ASSERT_EQ(trick_message_ptr1->cards[1].color(), Color::Hearts);
+        ASSERT_EQ(trick_message_ptr1->cards[2].figure(), "10");
+        ASSERT_EQ(trick_message_ptr1->cards[2].color(), Color::Diamonds);
     }
 
     std::shared_ptr<TRICKMessage> trick_message_ptr2 = std::dynamic_pointer_cast<TRICKMessage>(message_ptr2);
@@ -419,15 +602,43 @@ TEST(TRICKMessageSuite, FromString)
     {
         ASSERT_EQ(trick_message_ptr2->trick_number, 10);
         ASSERT_EQ(trick_message_ptr2->cards.size(), 3);
-        ASSERT_EQ(trick_message_ptr2->cards[0].figure, "A");
-        ASSERT_EQ(trick_message_ptr2->cards[0].color, Color::Spades);
-        ASSERT_EQ(trick_message_ptr2->cards[1].figure, "K");
-        ASSERT_EQ(trick_message_ptr2->cards[1].color, Color::Hearts);
-        ASSERT_EQ(trick_message_ptr2->cards[2].figure, "10");
-        ASSERT_EQ(trick_message_ptr2->cards[2].color, Color::Diamonds);
+        ASSERT_EQ(trick_message_ptr2->cards[0].figure(), "A");
+        ASSERT_EQ(trick_message_ptr2->cards[0].color(), Color::Spades);
+        ASSERT_EQ(trick_message_ptr2->cards[1].figure(), "K");
+        ASSERT_EQ(trick_message_ptr2->cards[1].color(), Color::Hearts);
+        ASSERT_EQ(trick_message_ptr2->cards[2].figure(), "10");
+        ASSERT_EQ(trick_message_ptr2->cards[2].color(), Color::Diamonds);
     }
 }
 
+TEST(TRICKMessageSuite, FromStringTrickNumberDigits)
+{
+    // Arrange
+    std::string message_str1 = "TRICK12C\r\n";
+    std::string message_str2 = "TRICK122C\r\n";
+    std::string message_str3 = "TRICK13\r\n";
+    std::string message_str4 = "TRICK1A\r\n";
+
+    // Act
+    std::shared_ptr<TRICKMessage> message_ptr1 = std::dynamic_pointer_cast<TRICKMessage>(Message::from_string(message_str1));
+    std::shared_ptr<TRICKMessage> message_ptr2 = std::dynamic_pointer_cast<TRICKMessage>(Message::from_string(message_str2));
+    std::shared_ptr<TRICKMessage> message_ptr3 = std::dynamic_pointer_cast<TRICKMessage>(Message::from_string(message_str3));
+    ASSERT_THROW(Message::from_string(message_str4), std::invalid_argument);
+
+    // Assert
+    ASSERT_NE(message_ptr1, nullptr);
+    ASSERT_NE(message_ptr2, nullptr);
+    ASSERT_NE(message_ptr3, nullptr);
+    ASSERT_EQ(message_ptr1->trick_number, 1);
+    ASSERT_EQ(message_ptr1->cards.size(), 1);
+    ASSERT_EQ(message_ptr1->cards[0].to_string(), "2C");
+    ASSERT_EQ(message_ptr2->trick_number, 12);
+    ASSERT_EQ(message_ptr2->cards.size(), 1);
+    ASSERT_EQ(message_ptr2->cards[0].to_string(), "2C");
+    ASSERT_EQ(message_ptr3->trick_number, 13);
+    ASSERT_EQ(message_ptr3->cards.size(), 0);
+}
+
 TEST(WRONGMessageSuite, Constructor)
 {
     // Arrange
@@ -517,8 +728,8 @@ TEST(TAKENMessageSuite, Constructor)
     ASSERT_EQ(message.cards.size(), cards1.size());
     for (size_t i = 0; i < cards1.size(); ++i)
     {
-        ASSERT_EQ(message.cards[i].figure, cards1[i].figure);
-        ASSERT_EQ(message.cards[i].color, cards1[i].color);
+        ASSERT_EQ(message.cards[i].figure(), cards1[i].figure());
+        ASSERT_EQ(message.cards[i].color(), cards1[i].color());
     }
     ASSERT_EQ(message.taken_by, position);
 }
@@ -559,14 +770,14 @@ TEST(TAKENMessageSuite, FromString)
     {
         ASSERT_EQ(taken_message_ptr1->trick_number, 1);
         ASSERT_EQ(taken_message_ptr1->cards.size(), 4);
-        ASSERT_EQ(taken_message_ptr1->cards[0].figure, "A");
-        ASSERT_EQ(taken_message_ptr1->cards[0].color, Color::Spades);
-        ASSERT_EQ(taken_message_ptr1->cards[1].figure, "K");
-        ASSERT_EQ(taken_message_ptr1->cards[1].color, Color::Hearts);
-        ASSERT_EQ(taken_message_ptr1->cards[2].figure, "10");
-        ASSERT_EQ(taken_message_ptr1->cards[2].color, Color::Diamonds);
-        ASSERT_EQ(taken_message_ptr1->cards[3].figure, "7");
-        ASSERT_EQ(taken_message_ptr1->cards[3].color, Color::Clubs);
+        ASSERT_EQ(taken_message_ptr1->cards[0].figure(), "A");
+        ASSERT_EQ(taken_message_ptr1->cards[0].color(), Color::Spades);
+        ASSERT_EQ(taken_message_ptr1->cards[1].figure(), "K");
+        ASSERT_EQ(taken_message_ptr1->cards[1].color(), Color::Hearts);
+        ASSERT_EQ(taken_message_ptr1->cards[2].figure(), "10");
+        ASSERT_EQ(taken_message_ptr1->cards[2].color(), Color::Diamonds);
+        ASSERT_EQ(taken_message_ptr1->cards[3].figure(), "7");
+        ASSERT_EQ(taken_message_ptr1->cards[3].color(), Color::Clubs);
         ASSERT_EQ(taken_message_ptr1->taken_by, Position::North);
     }
 
@@ -576,14 +787,14 @@ TEST(TAKENMessageSuite, FromString)
     {
         ASSERT_EQ(taken_message_ptr2->trick_number, 13);
         ASSERT_EQ(taken_message_ptr2->cards.size(), 4);
-        ASSERT_EQ(taken_message_ptr2->cards[0].figure, "A");
-        ASSERT_EQ(taken_message_ptr2->cards[0].color, Color::Spades);
-        ASSERT_EQ(taken_message_ptr2->cards[1].figure, "K");
-        ASSERT_EQ(taken_message_ptr2->cards[1].color, Color::Hearts);
-        ASSERT_EQ(taken_message_ptr2->cards[2].figure, "10");
-        ASSERT_EQ(taken_message_ptr2->cards[2].color, Color::Diamonds);
-        ASSERT_EQ(taken_message_ptr2->cards[3].figure, "7");
-        ASSERT_EQ(taken_message_ptr2->cards[3].color, Color::Clubs);
+        ASSERT_EQ(taken_message_ptr2->cards[0].figure(), "A");
+        ASSERT_EQ(taken_message_ptr2->cards[0].color(), Color::Spades);
+        ASSERT_EQ(taken_message_ptr2->cards[1].figure(), "K");
+        ASSERT_EQ(taken_message_ptr2->cards[1].color(), Color::Hearts);
+        ASSERT_EQ(taken_message_ptr2->cards[2].figure(), "10");
+        ASSERT_EQ(taken_message_ptr2->cards[2].color(), Color::Diamonds);
+        ASSERT_EQ(taken_message_ptr2->cards[3].figure(), "7");
+        ASSERT_EQ(taken_message_ptr2->cards[3].color(), Color::Clubs);
         ASSERT_EQ(taken_message_ptr2->taken_by, Position::North);
     }
 }
@@ -666,6 +877,39 @@ TEST(SCOREMessageSuite, FromString)
     }
 }
 
+TEST(SCOREMessageSuite, FromStringMalformed)
+{
+    // Arrange
+    std::string message1 = "SCOREN10N20S30W40\r\n";
+    std::string message2 = "SCOREN10E20S30W40N50\r\n";
+    std::string message3 = "SCOREN10E20S30W\r\n";
+    std::string message4 = "SCOREN1234567890E20S30W40\r\n";
+    std::string message5 = "SCOREN10E20S30W40X\r\n";
+
+    // Act & Assert
+    ASSERT_THROW(Message::from_string(message1), std::invalid_argument);
+    ASSERT_THROW(Message::from_string(message2), std::invalid_argument);
+    ASSERT_THROW(Message::from_string(message3), std::invalid_argument);
+    ASSERT_THROW(Message::from_string(message4), std::invalid_argument);
+    ASSERT_THROW(Message::from_string(message5), std::invalid_argument);
+}
+
+TEST(SCOREMessageSuite, Scores)
+{
+    // Arrange
+    Scores scores;
+    scores[Position::North] = 10;
+    scores[Position::West] = 40;
+
+    // Act
+    SCOREMessage scoreMessage(scores);
+    AnyMessage parsed = parse_message("SCOREW40E0N10S0\r\n");
+
+    // Assert
+    ASSERT_EQ(scoreMessage.to_string(), "SCOREN10E0S0W40\r\n");
+    ASSERT_TRUE(std::get<SCOREMessage>(parsed).scores == scores);
+}
+
 TEST(TOTALMessageSuite, Constructor)
 {
     // Arrange
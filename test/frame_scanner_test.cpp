@@ -0,0 +1,41 @@
+#include <gtest/gtest.h>
+#include <string>
+#include <vector>
+
+#include "frame-scanner.h"
+#include "frame_scanner_test.h"
+
+TEST(FrameScannerTest, FindLineEnds)
+{
+    std::string bytes = "IAMN\r\n" + std::string(40, 'x') + "\n\n" + std::string(20, 'y') + "TRICK12C\r\n";
+    std::vector<size_t> ends;
+
+    find_line_ends(bytes.data(), bytes.size(), 100, ends);
+
+    ASSERT_EQ(ends, (std::vector<size_t>{106, 147, 148, 178}));
+}
+
+TEST(FrameScannerTest, FindLineEndsAtEveryOffset)
+{
+    for (size_t newline = 0; newline < 70; newline++)
+    {
+        std::string bytes(70, 'x');
+        bytes[newline] = '\n';
+        std::vector<size_t> ends;
+
+        find_line_ends(bytes.data(), bytes.size(), 0, ends);
+
+        ASSERT_EQ(ends, (std::vector<size_t>{newline + 1}));
+    }
+}
+
+TEST(FrameScannerTest, FindLineEndsNone)
+{
+    std::string bytes(100, 'x');
+    std::vector<size_t> ends;
+
+    find_line_ends(bytes.data(), bytes.size(), 0, ends);
+    find_line_ends(bytes.data(), 0, 0, ends);
+
+    ASSERT_TRUE(ends.empty());
+}
\ No newline at end of file
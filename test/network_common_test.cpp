@@ -1,5 +1,8 @@
 #include <gtest/gtest.h>
 #include <regex>
+#include <sys/socket.h>
+#include <unistd.h>
+#include <string.h>
 
 #include "network-common.h"
 
@@ -10,4 +13,228 @@ TEST(CurrentTimeToStringTest, ReturnsCorrectFormat)
     std::regex time_format("\\d{4}-\\d{2}-\\d{2}T\\d{2}:\\d{2}:\\d{2}\\.\\d{3}");
     std::cout << time_str << '\n';
     ASSERT_TRUE(std::regex_match(time_str, time_format));
-}
\ No newline at end of file
+}
+
+TEST(SocketTest, ExtractMessage)
+{
+    int fds[2];
+    ASSERT_EQ(socketpair(AF_UNIX, SOCK_STREAM, 0, fds), 0);
+    Socket socket(fds[0], "", 0, "", 0);
+
+    std::string data = "IAMN\r\nTRICK1" + std::string(MAX_MESSAGE_SIZE, 'x') + "\r\nTRI";
+    ASSERT_EQ(write(fds[1], data.data(), data.size()), static_cast<ssize_t>(data.size()));
+    socket.handle_read();
+
+    ASSERT_EQ(socket.extract_message(), "IAMN\r\n");
+    ASSERT_EQ(socket.extract_message(), "TRICK1" + std::string(MAX_MESSAGE_SIZE - 6, 'x'));
+    ASSERT_EQ(socket.extract_message(), "xxxxxx\r\n");
+    ASSERT_EQ(socket.extract_message(), "");
+
+    close(fds[1]);
+    socket.handle_read();
+    ASSERT_EQ(socket.extract_message(), "");
+    ASSERT_TRUE(socket.all_messages_received);
+}
+
+TEST(SocketTest, NextMessageAcrossReads)
+{
+    int fds[2];
+    ASSERT_EQ(socketpair(AF_UNIX, SOCK_STREAM, 0, fds), 0);
+    Socket socket(fds[0], "", 0, "", 0);
+
+    for (const char *part : {"TRI", "CK1", "2C\r"})
+    {
+        ASSERT_EQ(write(fds[1], part, strlen(part)), static_cast<ssize_t>(strlen(part)));
+        socket.handle_read();
+        ASSERT_TRUE(socket.next_message().empty());
+    }
+
+    ASSERT_EQ(write(fds[1], "\nIAMS\r\n", 7), 7);
+    socket.handle_read();
+
+    ASSERT_EQ(socket.next_message(), "TRICK12C\r\n");
+    ASSERT_EQ(socket.next_message(), "IAMS\r\n");
+    ASSERT_TRUE(socket.next_message().empty());
+
+    close(fds[1]);
+}
+
+TEST(SocketTest, NextMessageUntilReleased)
+{
+    int fds[2];
+    ASSERT_EQ(socketpair(AF_UNIX, SOCK_STREAM, 0, fds), 0);
+    Socket socket(fds[0], "", 0, "", 0);
+
+    ASSERT_EQ(write(fds[1], "IAMN\r\nTRICK12C\r\n", 16), 16);
+    socket.handle_read();
+    std::string_view message = socket.next_message();
+
+    ASSERT_EQ(write(fds[1], "IAMS\r\n", 6), 6);
+    socket.handle_read();
+    ASSERT_EQ(message, "IAMN\r\n");
+
+    socket.release_message();
+    ASSERT_EQ(socket.next_message(), "TRICK12C\r\n");
+    ASSERT_EQ(socket.next_message(), "IAMS\r\n");
+    ASSERT_TRUE(socket.next_message().empty());
+
+    close(fds[1]);
+}
+
+TEST(SocketTest, BinaryFrames)
+{
+    int fds[2];
+    ASSERT_EQ(socketpair(AF_UNIX, SOCK_STREAM, 0, fds), 0);
+    Socket socket(fds[0], "", 0, "", 0);
+    socket.binary = true;
+
+    ASSERT_EQ(write(fds[1], "\x04\x03\x01", 3), 3);
+    socket.handle_read();
+    ASSERT_TRUE(socket.next_message().empty());
+
+    ASSERT_EQ(write(fds[1], "\x00IAMN\r\n", 7), 7);
+    socket.handle_read();
+    ASSERT_EQ(socket.next_message(), std::string("\x04\x03\x01\x00", 4));
+    ASSERT_EQ(socket.next_message(), "IAMN\r\n");
+    ASSERT_TRUE(socket.next_message().empty());
+
+    socket.send(WRONGMessage(7));
+    socket.handle_write();
+    char frame[4];
+    ASSERT_EQ(read(fds[1], frame, sizeof(frame)), 3);
+    ASSERT_EQ(std::string(frame, 3), "\x03\x04\x07");
+
+    close(fds[1]);
+}
+
+TEST(SocketTest, BinaryStrayLineEnd)
+{
+    int fds[2];
+    ASSERT_EQ(socketpair(AF_UNIX, SOCK_STREAM, 0, fds), 0);
+    Socket socket(fds[0], "", 0, "", 0);
+    socket.binary = true;
+
+    // The line end bytes start no frame, the frame after them is read whole.
+    ASSERT_EQ(write(fds[1], "\r\n\x03\x04\x07", 5), 5);
+    socket.handle_read();
+    ASSERT_EQ(socket.next_message(), "\r");
+    ASSERT_EQ(socket.next_message(), "\n");
+    ASSERT_EQ(socket.next_message(), "\x03\x04\x07");
+    ASSERT_TRUE(socket.next_message().empty());
+
+    close(fds[1]);
+}
+
+TEST(SocketTest, NextMessageFromBatch)
+{
+    int fds[2];
+    ASSERT_EQ(socketpair(AF_UNIX, SOCK_STREAM, 0, fds), 0);
+    Socket socket(fds[0], "", 0, "", 0);
+    socket.binary = true;
+
+    std::string batch;
+    for (int i = 0; i < 100; i++)
+        batch += "TRICK1" + std::to_string(i % 10 + 2) + "C\r\n";
+    batch += std::string(60, 'x') + "\r\n";
+    batch += std::string("\x03\x04\x0a", 3) + "IAMN\r\n";
+    ASSERT_EQ(write(fds[1], batch.data(), batch.size()), (ssize_t)batch.size());
+    socket.handle_read();
+
+    for (int i = 0; i < 100; i++)
+        ASSERT_EQ(socket.next_message(), "TRICK1" + std::to_string(i % 10 + 2) + "C\r\n");
+    ASSERT_EQ(socket.next_message(), std::string(MAX_MESSAGE_SIZE, 'x'));
+    ASSERT_EQ(socket.next_message(), std::string(10, 'x') + "\r\n");
+    ASSERT_EQ(socket.next_message(), std::string("\x03\x04\x0a", 3));
+    ASSERT_EQ(socket.next_message(), "IAMN\r\n");
+    ASSERT_TRUE(socket.next_message().empty());
+
+    close(fds[1]);
+}
+
+TEST(SocketTest, SendSharedBuffers)
+{
+    int fds[2];
+    ASSERT_EQ(socketpair(AF_UNIX, SOCK_STREAM, 0, fds), 0);
+    Socket first(fds[0], "", 0, "", 0);
+
+    SharedBuffer taken = std::make_shared<const std::string>("TAKEN12C3C4C5CN\r\n");
+    first.send("DEAL");
+    first.send(taken);
+    first.send("SCORE");
+    first.send("N0\r\n");
+    first.send(taken);
+    ASSERT_TRUE(first.has_pending_output());
+
+    first.handle_write();
+    ASSERT_FALSE(first.has_pending_output());
+
+    char buffer[100];
+    ssize_t length = read(fds[1], buffer, sizeof(buffer));
+    ASSERT_EQ(std::string(buffer, length), "DEALTAKEN12C3C4C5CN\r\nSCOREN0\r\nTAKEN12C3C4C5CN\r\n");
+
+    close(fds[1]);
+}
+
+TEST(SocketTest, PendingOutputBytes)
+{
+    int fds[2];
+    ASSERT_EQ(socketpair(AF_UNIX, SOCK_STREAM, 0, fds), 0);
+    Socket first(fds[0], "", 0, "", 0);
+
+    SharedBuffer taken = std::make_shared<const std::string>("TAKEN12C3C4C5CN\r\n");
+    first.send("DEAL");
+    first.send(taken);
+    ASSERT_EQ(first.pending_output_bytes(), 4 + taken->size());
+
+    // Partially sent chunks count only their rest.
+    first.handle_sent(6);
+    ASSERT_EQ(first.pending_output_bytes(), taken->size() - 2);
+
+    first.handle_write();
+    ASSERT_EQ(first.pending_output_bytes(), 0u);
+
+    close(fds[1]);
+}
+TEST(SocketTest, WriteErrorClosesSocket)
+{
+    int fds[2];
+    ASSERT_EQ(socketpair(AF_UNIX, SOCK_STREAM, 0, fds), 0);
+    Socket socket(fds[0], "", 0, "", 0);
+
+    // Writing to a closed peer fails with EPIPE, the socket is closed instead of throwing.
+    close(fds[1]);
+    socket.send("IAMN\r\n");
+    ASSERT_NO_THROW(socket.handle_write());
+    ASSERT_TRUE(socket.closed);
+    ASSERT_TRUE(socket.all_messages_received);
+    ASSERT_TRUE(socket.all_messages_sent);
+}
+
+TEST(SocketTest, ReadQueueOverflowAbandonsSocket)
+{
+    int fds[2];
+    ASSERT_EQ(socketpair(AF_UNIX, SOCK_STREAM, 0, fds), 0);
+    Socket socket(fds[0], "", 0, "", 0);
+
+    // A peer sending more than the read queue holds before its messages are handled is dropped.
+    std::string flood(MAX_READ_QUEUE_SIZE + MAX_MESSAGE_SIZE, 'X');
+    ASSERT_EQ(write(fds[1], flood.data(), flood.size()), static_cast<ssize_t>(flood.size()));
+    socket.handle_read();
+    ASSERT_TRUE(socket.closed);
+    ASSERT_TRUE(socket.all_messages_received);
+    ASSERT_TRUE(socket.all_messages_sent);
+
+    close(fds[1]);
+}
+
+TEST(SocketTest, AcceptErrorKeepsListening)
+{
+    Socket listener(0);
+
+    // Errors of a single connection are skipped, running out of descriptors pauses accepting.
+    ASSERT_FALSE(listener.handle_accept_error(EAGAIN));
+    ASSERT_FALSE(listener.handle_accept_error(ECONNABORTED));
+    ASSERT_TRUE(listener.handle_accept_error(EMFILE));
+    ASSERT_TRUE(listener.handle_accept_error(ENFILE));
+    ASSERT_THROW(listener.handle_accept_error(EBADF), std::runtime_error);
+}
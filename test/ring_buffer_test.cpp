@@ -0,0 +1,88 @@
+#include <gtest/gtest.h>
+#include <string.h>
+#include <string>
+
+#include "ring-buffer.h"
+#include "ring_buffer_test.h"
+
+TEST(RingBufferTest, AppendAndConsume)
+{
+    RingBuffer buffer(8);
+    buffer.append("abcdef", 6);
+    ASSERT_EQ(buffer.size(), 6);
+    ASSERT_EQ(buffer.view(3), "abc");
+
+    buffer.consume(4);
+    buffer.append("ghij", 4);
+    ASSERT_EQ(buffer.size(), 6);
+    ASSERT_EQ(buffer.view(6), "efghij");
+
+    iovec segments[2];
+    ASSERT_EQ(buffer.readable_segments(segments), 2);
+    ASSERT_EQ(std::string(static_cast<char *>(segments[0].iov_base), segments[0].iov_len), "efgh");
+    ASSERT_EQ(std::string(static_cast<char *>(segments[1].iov_base), segments[1].iov_len), "ij");
+}
+
+TEST(RingBufferTest, FindAcrossWrap)
+{
+    RingBuffer buffer(8);
+    buffer.append("xxxxxx", 6);
+    buffer.consume(6);
+    buffer.append("ab\r\ncd", 6);
+
+    ASSERT_EQ(buffer.find('\n', 0, 8), 3);
+    ASSERT_EQ(buffer.find('\n', 0, 3), std::string::npos);
+    ASSERT_EQ(buffer.find('z', 0, 8), std::string::npos);
+    ASSERT_EQ(buffer.find('\n', 3, 8), 3);
+    ASSERT_EQ(buffer.find('\n', 4, 8), std::string::npos);
+    ASSERT_EQ(buffer.view(6), "ab\r\ncd");
+}
+
+TEST(RingBufferTest, GrowsWhenFull)
+{
+    RingBuffer buffer(4);
+    buffer.append("abc", 3);
+    buffer.consume(2);
+    buffer.append("defghij", 7);
+
+    ASSERT_EQ(buffer.size(), 8);
+    ASSERT_EQ(buffer.view(8), "cdefghij");
+
+    iovec segments[2];
+    int count = buffer.writable_segments(segments);
+    ASSERT_GE(count, 1);
+    ASSERT_GT(segments[0].iov_len, 0);
+}
+
+TEST(RingBufferTest, CommitWrittenSegments)
+{
+    RingBuffer buffer(8);
+    buffer.append("abcdef", 6);
+    buffer.consume(5);
+
+    iovec segments[2];
+    ASSERT_EQ(buffer.writable_segments(segments), 2);
+    ASSERT_EQ(segments[0].iov_len + segments[1].iov_len, 7);
+
+    memcpy(segments[0].iov_base, "gh", 2);
+    memcpy(segments[1].iov_base, "ij", 2);
+    buffer.commit(4);
+    ASSERT_EQ(buffer.view(5), "fghij");
+}
+
+TEST(RingBufferTest, CommitPreparedAcrossWrap)
+{
+    RingBuffer buffer(8);
+    buffer.append("abcdef", 6);
+    buffer.consume(5);
+
+    char *space = buffer.prepare(5);
+    memcpy(space, "ghijk", 5);
+    buffer.commit_prepared(5);
+
+    ASSERT_EQ(buffer.size(), 6);
+    iovec segments[2];
+    ASSERT_EQ(buffer.readable_segments(segments), 2);
+    ASSERT_EQ(std::string(static_cast<char *>(segments[0].iov_base), segments[0].iov_len), "fgh");
+    ASSERT_EQ(std::string(static_cast<char *>(segments[1].iov_base), segments[1].iov_len), "ijk");
+}
\ No newline at end of file
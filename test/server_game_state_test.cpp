@@ -0,0 +1,232 @@
+#include <gtest/gtest.h>
+#include <sys/socket.h>
+#include <unistd.h>
+#include <memory>
+#include <optional>
+#include <string>
+#include <vector>
+
+#include "server-game-state.h"
+#include "server_game_state_test.h"
+
+static const Position POSITIONS[4] = {Position::North, Position::East, Position::South, Position::West};
+
+/**
+ * @brief Table with all four players seated, each of them connected by a socket pair
+ */
+struct TestTable
+{
+    ServerGameState game_state;
+    std::shared_ptr<Socket> sockets[4];
+    int peer_fds[4];
+
+    // Without the auto_play flag the table is built with the default of ServerGameState.
+    TestTable(std::shared_ptr<const GameDefinition> definition, std::optional<bool> auto_play = std::nullopt)
+        : game_state(auto_play.has_value() ? ServerGameState(definition, 5, auto_play.value()) : ServerGameState(definition, 5))
+    {
+        for (int i = 0; i < 4; i++)
+        {
+            int fds[2];
+            EXPECT_EQ(socketpair(AF_UNIX, SOCK_STREAM, 0, fds), 0);
+            sockets[i] = std::make_shared<Socket>(fds[0], "", 0, "", 0);
+            peer_fds[i] = fds[1];
+            game_state.new_player(POSITIONS[i], sockets[i]);
+        }
+    }
+
+    ~TestTable()
+    {
+        for (int fd : peer_fds)
+            close(fd);
+    }
+
+    /**
+     * @brief Take the messages sent to a player since the last call
+     *
+     * @param player_idx The player's index in order
+     * @return Messages without their terminators
+     */
+    std::vector<std::string> received(int player_idx)
+    {
+        while (sockets[player_idx]->has_pending_output())
+            sockets[player_idx]->handle_write();
+
+        std::string data;
+        char buffer[4096];
+        ssize_t length;
+        while ((length = recv(peer_fds[player_idx], buffer, sizeof(buffer), MSG_DONTWAIT)) > 0)
+            data.append(buffer, length);
+
+        std::vector<std::string> messages;
+        for (size_t start = 0, end; (end = data.find("\r\n", start)) != std::string::npos; start = end + 2)
+            messages.push_back(data.substr(start, end - start));
+
+        return messages;
+    }
+
+    /**
+     * @brief Play the highest valid card of the awaited player
+     */
+    void play_highest()
+    {
+        Position position = game_state.awaited_player.value();
+        int player_idx = position == Position::North ? 0 : position == Position::East ? 1 : position == Position::South ? 2 : 3;
+
+        CardMask hand = game_state.current_hands[player_idx];
+        if (!game_state.trick_cards.empty() && (hand & color_mask(game_state.trick_cards[0].color())) != 0)
+            hand &= color_mask(game_state.trick_cards[0].color());
+
+        play(player_idx, Card(static_cast<uint8_t>(63 - __builtin_clzll(hand))));
+    }
+
+    /**
+     * @brief Play a card of a player and continue the game
+     *
+     * @param player_idx The player's index in order
+     * @param card The card
+     */
+    void play(int player_idx, Card card)
+    {
+        TRICKMessage trick_message(game_state.current_trick, CardList{card});
+        std::optional<WRONGMessage> wrong = game_state.handle_trick_message(sockets[player_idx], trick_message);
+        ASSERT_FALSE(wrong.has_value());
+        game_state.continue_game();
+    }
+};
+
+/**
+ * @brief Game of a single deal, every player holds a whole color and North starts
+ *
+ * @param deal_type Type of the deal
+ * @return Game definition
+ */
+static std::shared_ptr<const GameDefinition> single_color_hands(DealType deal_type)
+{
+    auto definition = std::make_shared<GameDefinition>();
+    definition->deal_types = {deal_type};
+    definition->starting_players = {Position::North};
+    definition->hands = {{Card::parse_cards("2C3C4C5C6C7C8C9C10CJCQCKCAC")},
+                         {Card::parse_cards("2D3D4D5D6D7D8D9D10DJDQDKDAD")},
+                         {Card::parse_cards("2H3H4H5H6H7H8H9H10HJHQHKHAH")},
+                         {Card::parse_cards("2S3S4S5S6S7S8S9S10SJSQSKSAS")}};
+    return definition;
+}
+
+/**
+ * @brief Play the deal until it ends, every player plays its highest valid card
+ *
+ * @param table The table
+ * @return Messages received by North during the deal
+ */
+static std::vector<std::string> play_deal(TestTable &table)
+{
+    table.game_state.continue_game();
+    std::vector<std::string> messages = table.received(0);
+
+    while (!table.game_state.game_ended)
+    {
+        table.play_highest();
+        for (const std::string &message : table.received(0))
+            messages.push_back(message);
+    }
+
+    return messages;
+}
+
+/**
+ * @brief Count messages starting with a header
+ *
+ * @param messages Messages
+ * @param header Header
+ * @return Number of messages
+ */
+static int count_messages(const std::vector<std::string> &messages, const std::string &header)
+{
+    int count = 0;
+    for (const std::string &message : messages)
+        if (message.compare(0, header.size(), header) == 0)
+            count++;
+    return count;
+}
+
+TEST(ServerGameStateTest, KingHeartDealEndsAfterKingIsTaken)
+{
+    TestTable table(single_color_hands(DealType::KING_HEART));
+
+    std::vector<std::string> messages = play_deal(table);
+
+    // South plays AH and then KH, North takes both tricks and no points are left.
+    std::vector<std::string> expected = {
+        "DEAL5N2C3C4C5C6C7C8C9C10CJCQCKCAC",
+        "TRICK1",
+        "TAKEN1ACADAHASN",
+        "TRICK2",
+        "TAKEN2KCKDKHKSN",
+        "SCOREN18E0S0W0",
+        "TOTALN18E0S0W0",
+    };
+    ASSERT_EQ(messages, expected);
+}
+
+TEST(ServerGameStateTest, TrickDealPlaysAllTricks)
+{
+    TestTable table(single_color_hands(DealType::TRICK));
+
+    std::vector<std::string> messages = play_deal(table);
+
+    // Every trick scores, so points are left until the last one.
+    ASSERT_EQ(count_messages(messages, "TAKEN"), 13);
+    ASSERT_EQ(messages[messages.size() - 3], "TAKEN132C2D2H2SN");
+    ASSERT_EQ(messages[messages.size() - 2], "SCOREN13E0S0W0");
+    ASSERT_EQ(messages.back(), "TOTALN13E0S0W0");
+}
+
+/**
+ * @brief Game of a single deal in which East holds a single club and North starts
+ *
+ * @return Game definition
+ */
+static std::shared_ptr<const GameDefinition> single_club_in_east()
+{
+    auto definition = std::make_shared<GameDefinition>();
+    definition->deal_types = {DealType::TRICK};
+    definition->starting_players = {Position::North};
+    definition->hands = {{Card::parse_cards("2C3C4C5C6C7C8C9C10CJCQCKCAS")},
+                         {Card::parse_cards("AC2D3D4D5D6D7D8D9D10DJDQDKD")},
+                         {Card::parse_cards("2H3H4H5H6H7H8H9H10HJHQHKHAH")},
+                         {Card::parse_cards("AD2S3S4S5S6S7S8S9S10SJSQSKS")}};
+    return definition;
+}
+
+TEST(ServerGameStateTest, AutoPlayIsOffByDefault)
+{
+    TestTable table(single_club_in_east());
+    table.game_state.continue_game();
+    table.received(1);
+
+    ASSERT_FALSE(table.game_state.auto_play);
+
+    // East has to follow with AC, it is asked for it anyway.
+    table.play(0, Card("2C"));
+    ASSERT_EQ(table.game_state.awaited_player, Position::East);
+    ASSERT_EQ(table.received(1), std::vector<std::string>({"TRICK12C"}));
+}
+
+TEST(ServerGameStateTest, AutoPlayForcedMove)
+{
+    TestTable table(single_club_in_east(), true);
+    table.game_state.continue_game();
+    table.received(1);
+
+    // East's only valid card is played right away, South is asked next.
+    table.play(0, Card("2C"));
+    ASSERT_EQ(table.game_state.awaited_player, Position::South);
+    ASSERT_EQ(table.game_state.current_hands[1] & card_mask(Card("AC")), 0u);
+    ASSERT_TRUE(table.received(1).empty());
+
+    table.play(2, Card("2H"));
+    table.play(3, Card("2S"));
+
+    // East sees its card only in the TAKEN message.
+    ASSERT_EQ(table.received(1), std::vector<std::string>({"TAKEN12CAC2H2SE", "TRICK2"}));
+}
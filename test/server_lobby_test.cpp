@@ -0,0 +1,31 @@
+#include <gtest/gtest.h>
+
+#include "server-lobby.h"
+#include "server_lobby_test.h"
+
+TEST(TableDirectoryTest, AbandonedTableIsRemoved)
+{
+    TableDirectory directory(1);
+
+    std::optional<int> table_id = directory.reserve(Position::North, std::nullopt);
+    ASSERT_TRUE(table_id.has_value());
+    ASSERT_FALSE(directory.reserve(Position::North, 7).has_value());
+
+    // Nobody is left at the table before its game started, so it no longer counts against the limit.
+    ASSERT_TRUE(directory.release(table_id.value(), Position::North));
+    ASSERT_EQ(directory.reserve(Position::North, 7), std::optional<int>(7));
+}
+
+TEST(TableDirectoryTest, StartedTableIsKept)
+{
+    TableDirectory directory(1);
+
+    for (auto position : {Position::North, Position::East, Position::South, Position::West})
+        ASSERT_EQ(directory.reserve(position, std::nullopt), std::optional<int>(1));
+
+    // Players of a started game may come back, its table stays.
+    for (auto position : {Position::North, Position::East, Position::South, Position::West})
+        ASSERT_FALSE(directory.release(1, position));
+    ASSERT_FALSE(directory.reserve(Position::North, 2).has_value());
+    ASSERT_EQ(directory.reserve(Position::North, std::nullopt), std::optional<int>(1));
+}
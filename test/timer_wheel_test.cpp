@@ -0,0 +1,94 @@
+#include <gtest/gtest.h>
+#include <vector>
+
+#include "timer-wheel.h"
+#include "timer_wheel_test.h"
+
+TEST(TimerWheelTest, ExpiresAtDeadline)
+{
+    TimerWheel wheel(1000);
+    Timer timer;
+    timer.id = 7;
+
+    wheel.schedule(timer, 1010);
+    ASSERT_EQ(wheel.next_timeout(1000), 10);
+    ASSERT_TRUE(wheel.advance(1009).empty());
+    ASSERT_EQ(wheel.advance(1010), std::vector<int>({7}));
+    ASSERT_FALSE(timer.armed);
+    ASSERT_EQ(wheel.size(), 0);
+    ASSERT_EQ(wheel.next_timeout(1010), -1);
+}
+
+TEST(TimerWheelTest, Cancel)
+{
+    TimerWheel wheel(0);
+    Timer first, second;
+    first.id = 1;
+    second.id = 2;
+
+    wheel.schedule(first, 50);
+    wheel.schedule(second, 50);
+    wheel.cancel(first);
+    wheel.cancel(first);
+
+    ASSERT_EQ(wheel.size(), 1);
+    ASSERT_EQ(wheel.advance(100), std::vector<int>({2}));
+}
+
+TEST(TimerWheelTest, Reschedule)
+{
+    TimerWheel wheel(0);
+    Timer timer;
+    timer.id = 1;
+
+    wheel.schedule(timer, 100);
+    wheel.schedule(timer, 5000);
+
+    ASSERT_EQ(wheel.size(), 1);
+    ASSERT_TRUE(wheel.advance(4999).empty());
+    ASSERT_EQ(wheel.advance(5000), std::vector<int>({1}));
+}
+
+TEST(TimerWheelTest, PastDeadlineExpiresRightAway)
+{
+    TimerWheel wheel(100);
+    Timer timer;
+    timer.id = 1;
+
+    wheel.schedule(timer, 10);
+    ASSERT_EQ(wheel.next_timeout(100), 0);
+    ASSERT_EQ(wheel.advance(100), std::vector<int>({1}));
+}
+
+TEST(TimerWheelTest, CascadesInDeadlineOrder)
+{
+    // Deadlines across all levels and beyond the range of the wheel.
+    std::vector<long long> deadlines = {3, 63, 64, 65, 4095, 4096, 5000, 262143, 262144, 300000, 16777215, 16777216, 20000000};
+
+    TimerWheel wheel(1);
+    std::vector<Timer> timers(deadlines.size());
+    for (size_t i = 0; i < deadlines.size(); i++)
+    {
+        timers[i].id = i;
+        wheel.schedule(timers[i], deadlines[i]);
+    }
+
+    long long now = 1;
+    std::vector<int> expired;
+    while (wheel.size() > 0)
+    {
+        int timeout = wheel.next_timeout(now);
+        ASSERT_GE(timeout, 0);
+        now += timeout;
+
+        for (int id : wheel.advance(now))
+        {
+            ASSERT_EQ(deadlines[id], now);
+            expired.push_back(id);
+        }
+    }
+
+    ASSERT_EQ(expired.size(), deadlines.size());
+    for (size_t i = 0; i < expired.size(); i++)
+        ASSERT_EQ(expired[i], static_cast<int>(i));
+}
\ No newline at end of file
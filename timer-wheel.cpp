@@ -0,0 +1,192 @@
+#include <climits>
+
+#include "timer-wheel.h"
+
+#define SLOT_MASK (TIMER_WHEEL_SLOTS - 1)
+
+static long long level_span(int level)
+{
+    return 1LL << (TIMER_WHEEL_SLOT_BITS * level);
+}
+
+static uint64_t rotate_right(uint64_t bits, int shift)
+{
+    return shift == 0 ? bits : (bits >> shift) | (bits << (64 - shift));
+}
+
+TimerWheel::TimerWheel(long long now)
+{
+    current = now;
+    timers_count = 0;
+
+    for (int level = 0; level < TIMER_WHEEL_LEVELS; level++)
+    {
+        occupied[level] = 0;
+        for (int slot = 0; slot < TIMER_WHEEL_SLOTS; slot++)
+            slots[level][slot] = nullptr;
+    }
+}
+
+void TimerWheel::schedule(Timer &timer, long long deadline)
+{
+    if (timer.armed && timer.deadline == deadline)
+        return;
+
+    cancel(timer);
+
+    timer.deadline = deadline;
+    timer.armed = true;
+    timers_count++;
+    insert(timer);
+}
+
+void TimerWheel::cancel(Timer &timer)
+{
+    if (!timer.armed)
+        return;
+
+    unlink(timer);
+    timer.armed = false;
+    timers_count--;
+}
+
+std::vector<int> TimerWheel::advance(long long now)
+{
+    std::vector<int> expired;
+
+    while (current <= now)
+    {
+        // Ticks without work are skipped, there is nothing to cascade or expire in them.
+        long long tick = next_tick();
+        if (tick == -1 || tick > now)
+        {
+            current = now + 1;
+            break;
+        }
+        current = tick;
+
+        for (int level = TIMER_WHEEL_LEVELS - 1; level > 0; level--)
+        {
+            if ((current & (level_span(level) - 1)) != 0)
+                continue;
+
+            Timer *timer = take_slot(level, (current >> (TIMER_WHEEL_SLOT_BITS * level)) & SLOT_MASK);
+            while (timer != nullptr)
+            {
+                Timer *next = timer->next;
+                insert(*timer);
+                timer = next;
+            }
+        }
+
+        Timer *timer = take_slot(0, current & SLOT_MASK);
+        while (timer != nullptr)
+        {
+            Timer *next = timer->next;
+            timer->armed = false;
+            timers_count--;
+            expired.push_back(timer->id);
+            timer = next;
+        }
+
+        current++;
+    }
+
+    return expired;
+}
+
+int TimerWheel::next_timeout(long long now) const
+{
+    long long tick = next_tick();
+    if (tick == -1)
+        return -1;
+    if (tick <= now)
+        return 0;
+    if (tick - now > INT_MAX)
+        return INT_MAX;
+    return static_cast<int>(tick - now);
+}
+
+int TimerWheel::size() const
+{
+    return timers_count;
+}
+
+/*
+ * Private functions
+ */
+
+void TimerWheel::insert(Timer &timer)
+{
+    long long tick = timer.deadline < current ? current : timer.deadline;
+    long long delta = tick - current;
+
+    int level = 0;
+    while (level < TIMER_WHEEL_LEVELS - 1 && delta >= level_span(level + 1))
+        level++;
+
+    // Timers beyond the range of the wheel wait in the last slot and are placed again when it cascades.
+    if (delta >= level_span(TIMER_WHEEL_LEVELS))
+        tick = current + level_span(TIMER_WHEEL_LEVELS) - 1;
+
+    int slot = (tick >> (TIMER_WHEEL_SLOT_BITS * level)) & SLOT_MASK;
+
+    timer.level = level;
+    timer.slot = slot;
+    timer.prev = nullptr;
+    timer.next = slots[level][slot];
+    if (timer.next != nullptr)
+        timer.next->prev = &timer;
+    slots[level][slot] = &timer;
+    occupied[level] |= 1ULL << slot;
+}
+
+void TimerWheel::unlink(Timer &timer)
+{
+    if (timer.prev != nullptr)
+        timer.prev->next = timer.next;
+    else
+        slots[timer.level][timer.slot] = timer.next;
+
+    if (timer.next != nullptr)
+        timer.next->prev = timer.prev;
+
+    if (slots[timer.level][timer.slot] == nullptr)
+        occupied[timer.level] &= ~(1ULL << timer.slot);
+
+    timer.prev = nullptr;
+    timer.next = nullptr;
+}
+
+Timer *TimerWheel::take_slot(int level, int slot)
+{
+    Timer *first = slots[level][slot];
+    slots[level][slot] = nullptr;
+    occupied[level] &= ~(1ULL << slot);
+    return first;
+}
+
+long long TimerWheel::next_tick() const
+{
+    if (timers_count == 0)
+        return -1;
+
+    long long tick = -1;
+
+    // Level 0 expires timers, higher levels cascade at the start of their slots.
+    for (int level = 0; level < TIMER_WHEEL_LEVELS; level++)
+    {
+        int shift = TIMER_WHEEL_SLOT_BITS * level;
+        long long first_slot = (current + level_span(level) - 1) >> shift;
+
+        uint64_t bits = rotate_right(occupied[level], first_slot & SLOT_MASK);
+        if (bits == 0)
+            continue;
+
+        long long slot_tick = (first_slot + __builtin_ctzll(bits)) << shift;
+        if (tick == -1 || slot_tick < tick)
+            tick = slot_tick;
+    }
+
+    return tick;
+}
\ No newline at end of file
@@ -0,0 +1,126 @@
+#ifndef TIMER_WHEEL_H
+#define TIMER_WHEEL_H
+
+#include <cstdint>
+#include <vector>
+
+#define TIMER_WHEEL_LEVELS 4
+#define TIMER_WHEEL_SLOT_BITS 6
+#define TIMER_WHEEL_SLOTS (1 << TIMER_WHEEL_SLOT_BITS)
+
+/**
+ * @brief Timer scheduled in a TimerWheel
+ *
+ * Timers are embedded in their owners and linked into the wheel, so arming
+ * and cancelling a timer does not allocate.
+ */
+struct Timer
+{
+    int id = -1;
+    long long deadline = 0;
+    bool armed = false;
+    int level = 0;
+    int slot = 0;
+    Timer *prev = nullptr;
+    Timer *next = nullptr;
+};
+
+/**
+ * @brief Hierarchical timer wheel with millisecond ticks
+ *
+ * Every level has 64 slots, a slot of level l covers 64^l ticks, so four
+ * levels cover about four and a half hours. Timers further away wait in the
+ * last level and are placed again when it cascades. Arming and cancelling
+ * a timer take constant time, expiring timers costs one step per tick
+ * with a timer due or a cascade to do.
+ */
+class TimerWheel
+{
+private:
+    long long current;
+    int timers_count;
+    Timer *slots[TIMER_WHEEL_LEVELS][TIMER_WHEEL_SLOTS];
+    uint64_t occupied[TIMER_WHEEL_LEVELS];
+
+public:
+    /**
+     * @brief Construct a new TimerWheel object
+     *
+     * @param now Current time in milliseconds
+     */
+    TimerWheel(long long now);
+
+    TimerWheel(const TimerWheel &) = delete;
+    TimerWheel &operator=(const TimerWheel &) = delete;
+
+    /**
+     * @brief Arm the timer, rearm it if it is already armed
+     *
+     * @param timer Timer
+     * @param deadline Time in milliseconds when the timer expires
+     */
+    void schedule(Timer &timer, long long deadline);
+
+    /**
+     * @brief Disarm the timer, does nothing if it is not armed
+     *
+     * @param timer Timer
+     */
+    void cancel(Timer &timer);
+
+    /**
+     * @brief Expire timers whose deadline has passed
+     *
+     * @param now Current time in milliseconds
+     * @return Ids of the expired timers, they are no longer armed
+     */
+    std::vector<int> advance(long long now);
+
+    /**
+     * @brief Get time until the wheel has work to do
+     *
+     * @param now Current time in milliseconds
+     * @return Timeout in milliseconds, -1 if no timer is armed
+     */
+    int next_timeout(long long now) const;
+
+    /**
+     * @brief Get number of armed timers
+     *
+     * @return Number of armed timers
+     */
+    int size() const;
+
+private:
+    /**
+     * @brief Link the timer into the slot matching its deadline
+     *
+     * @param timer Timer
+     */
+    void insert(Timer &timer);
+
+    /**
+     * @brief Unlink the timer from its slot
+     *
+     * @param timer Timer
+     */
+    void unlink(Timer &timer);
+
+    /**
+     * @brief Unlink all timers of a slot
+     *
+     * @param level Level
+     * @param slot Slot
+     * @return First timer of the slot
+     */
+    Timer *take_slot(int level, int slot);
+
+    /**
+     * @brief Get the tick when the wheel has work to do next
+     *
+     * @return Tick, -1 if no timer is armed
+     */
+    long long next_tick() const;
+};
+
+#endif // TIMER_WHEEL_H
\ No newline at end of file
@@ -0,0 +1,400 @@
+#include <algorithm>
+#include <sys/mman.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#include <poll.h>
+#include <string.h>
+#include <stdexcept>
+
+#include "uring-backend.h"
+
+#define OPERATION_MASK 7ULL
+
+static uint64_t user_data(UringClient *client, UringOperation operation)
+{
+    return reinterpret_cast<uint64_t>(client) | static_cast<uint64_t>(operation);
+}
+
+UringBackend::UringBackend()
+{
+    struct io_uring_params params;
+    memset(&params, 0, sizeof(params));
+
+    ring_fd = syscall(__NR_io_uring_setup, URING_ENTRIES, &params);
+    if (ring_fd == -1)
+        throw std::runtime_error(strerror(errno));
+
+    unsigned required_features = IORING_FEAT_SINGLE_MMAP | IORING_FEAT_NODROP | IORING_FEAT_EXT_ARG;
+    if ((params.features & required_features) != required_features)
+    {
+        close(ring_fd);
+        throw std::runtime_error("io_uring lacks required features");
+    }
+
+    sq_entries = params.sq_entries;
+    cq_entries = params.cq_entries;
+
+    // Both rings share one mapping.
+    rings_size = std::max(params.sq_off.array + sq_entries * sizeof(unsigned),
+                          params.cq_off.cqes + cq_entries * sizeof(io_uring_cqe));
+    rings = mmap(nullptr, rings_size, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, ring_fd, IORING_OFF_SQ_RING);
+    if (rings == MAP_FAILED)
+    {
+        close(ring_fd);
+        throw std::runtime_error(strerror(errno));
+    }
+
+    sqes_size = sq_entries * sizeof(io_uring_sqe);
+    sqes = static_cast<io_uring_sqe *>(mmap(nullptr, sqes_size, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, ring_fd, IORING_OFF_SQES));
+    if (sqes == MAP_FAILED)
+    {
+        munmap(rings, rings_size);
+        close(ring_fd);
+        throw std::runtime_error(strerror(errno));
+    }
+
+    char *base = static_cast<char *>(rings);
+    sq_head = reinterpret_cast<unsigned *>(base + params.sq_off.head);
+    sq_tail = reinterpret_cast<unsigned *>(base + params.sq_off.tail);
+    sq_mask = reinterpret_cast<unsigned *>(base + params.sq_off.ring_mask);
+    sq_array = reinterpret_cast<unsigned *>(base + params.sq_off.array);
+    cq_head = reinterpret_cast<unsigned *>(base + params.cq_off.head);
+    cq_tail = reinterpret_cast<unsigned *>(base + params.cq_off.tail);
+    cq_mask = reinterpret_cast<unsigned *>(base + params.cq_off.ring_mask);
+    cqes = reinterpret_cast<io_uring_cqe *>(base + params.cq_off.cqes);
+
+    pending_submissions = 0;
+    listener = nullptr;
+    accept_resume_time = -1;
+    inbox_fd = -1;
+}
+
+UringBackend::~UringBackend()
+{
+    // Closing the ring cancels the operations still in flight.
+    munmap(sqes, sqes_size);
+    munmap(rings, rings_size);
+    close(ring_fd);
+}
+
+void UringBackend::add_listener(Socket &listener)
+{
+    this->listener = &listener;
+    prepare_accept();
+}
+
+void UringBackend::add_inbox(int inbox_fd)
+{
+    this->inbox_fd = inbox_fd;
+    prepare_inbox();
+}
+
+void UringBackend::add_client(const std::shared_ptr<Socket> &socket)
+{
+    std::unique_ptr<UringClient> client = std::make_unique<UringClient>();
+    client->socket = socket;
+    client->receiving = false;
+    client->sending = false;
+    client->removed = false;
+    client->throttled = false;
+
+    if (!socket->closed)
+        prepare_receive(*client);
+
+    clients[socket->socket_fd] = std::move(client);
+}
+
+void UringBackend::remove_client(const std::shared_ptr<Socket> &socket)
+{
+    auto it = clients.find(socket->socket_fd);
+    if (it == clients.end())
+        return;
+
+    UringClient &client = *it->second;
+    if (!client.receiving && !client.sending)
+    {
+        clients.erase(it);
+        return;
+    }
+
+    // Buffers of the operations in flight stay alive until their completions arrive.
+    client.removed = true;
+    if (client.receiving)
+        prepare_cancel(client, UringOperation::Receive);
+    if (client.sending)
+        prepare_cancel(client, UringOperation::Send);
+
+    removed_clients[&client] = std::move(it->second);
+    clients.erase(it);
+}
+
+void UringBackend::flush_client(const std::shared_ptr<Socket> &socket)
+{
+    auto it = clients.find(socket->socket_fd);
+    if (it == clients.end())
+        return;
+
+    UringClient &client = *it->second;
+
+    if (!client.sending)
+    {
+        if (socket->has_pending_output())
+            prepare_send(client);
+        else if (socket->closed)
+            socket->all_messages_sent = true;
+    }
+
+    if (!client.receiving && !client.throttled && !socket->closed)
+        prepare_receive(client);
+}
+
+void UringBackend::throttle_client(const std::shared_ptr<Socket> &socket, bool throttled)
+{
+    auto it = clients.find(socket->socket_fd);
+    if (it == clients.end())
+        return;
+
+    // A receive already in flight completes as usual, the next one is queued only once the client is resumed.
+    UringClient &client = *it->second;
+    client.throttled = throttled;
+
+    if (!throttled && !client.receiving && !socket->closed)
+        prepare_receive(client);
+}
+
+int UringBackend::wait(int timeout)
+{
+    events.clear();
+
+    if (accept_resume_time >= 0)
+    {
+        if (get_monotonic_time_in_millis() >= accept_resume_time)
+        {
+            prepare_accept();
+            accept_resume_time = -1;
+        }
+        else
+            timeout = timeout_until(timeout, accept_resume_time);
+    }
+
+    // Queued submissions go in with the same call that waits, unless completions are already there.
+    bool completed = __atomic_load_n(cq_tail, __ATOMIC_ACQUIRE) != *cq_head;
+    enter(!completed, timeout);
+
+    unsigned head = *cq_head;
+    while (head != __atomic_load_n(cq_tail, __ATOMIC_ACQUIRE))
+    {
+        io_uring_cqe cqe = cqes[head & *cq_mask];
+        head++;
+        __atomic_store_n(cq_head, head, __ATOMIC_RELEASE);
+
+        handle_completion(cqe);
+    }
+
+    return events.size();
+}
+
+const IOEvent &UringBackend::event(int idx) const
+{
+    return events[idx];
+}
+
+/*
+ * Private functions
+ */
+
+io_uring_sqe *UringBackend::next_submission()
+{
+    unsigned tail = *sq_tail;
+    if (tail - __atomic_load_n(sq_head, __ATOMIC_ACQUIRE) == sq_entries)
+    {
+        enter(false, 0);
+        if (tail - __atomic_load_n(sq_head, __ATOMIC_ACQUIRE) == sq_entries)
+            throw std::runtime_error("io_uring submission queue full");
+    }
+
+    unsigned idx = tail & *sq_mask;
+    io_uring_sqe *sqe = &sqes[idx];
+    memset(sqe, 0, sizeof(*sqe));
+    sq_array[idx] = idx;
+
+    return sqe;
+}
+
+void UringBackend::queue_submission()
+{
+    __atomic_store_n(sq_tail, *sq_tail + 1, __ATOMIC_RELEASE);
+    pending_submissions++;
+}
+
+void UringBackend::enter(bool wait_for_completion, int timeout)
+{
+    if (!wait_for_completion && pending_submissions == 0)
+        return;
+
+    struct __kernel_timespec ts;
+    struct io_uring_getevents_arg arg;
+    memset(&arg, 0, sizeof(arg));
+
+    unsigned flags = 0;
+    unsigned min_complete = 0;
+    if (wait_for_completion)
+    {
+        flags = IORING_ENTER_GETEVENTS | IORING_ENTER_EXT_ARG;
+        min_complete = 1;
+
+        if (timeout >= 0)
+        {
+            ts.tv_sec = timeout / 1000;
+            ts.tv_nsec = (timeout % 1000) * 1000000LL;
+            arg.ts = reinterpret_cast<uint64_t>(&ts);
+        }
+    }
+
+    int submitted = syscall(__NR_io_uring_enter, ring_fd, pending_submissions, min_complete, flags,
+                            wait_for_completion ? &arg : nullptr, wait_for_completion ? sizeof(arg) : 0);
+    if (submitted == -1)
+    {
+        if (errno == ETIME || errno == EINTR)
+            return;
+        throw std::runtime_error(strerror(errno));
+    }
+
+    pending_submissions -= submitted;
+}
+
+void UringBackend::prepare_accept()
+{
+    accept_address_length = sizeof(accept_address);
+
+    io_uring_sqe *sqe = next_submission();
+    sqe->opcode = IORING_OP_ACCEPT;
+    sqe->fd = listener->socket_fd;
+    sqe->addr = reinterpret_cast<uint64_t>(&accept_address);
+    sqe->addr2 = reinterpret_cast<uint64_t>(&accept_address_length);
+    sqe->user_data = user_data(nullptr, UringOperation::Accept);
+    queue_submission();
+}
+
+void UringBackend::prepare_inbox()
+{
+    io_uring_sqe *sqe = next_submission();
+    sqe->opcode = IORING_OP_POLL_ADD;
+    sqe->fd = inbox_fd;
+    sqe->poll32_events = POLLIN;
+    sqe->user_data = user_data(nullptr, UringOperation::Inbox);
+    queue_submission();
+}
+
+void UringBackend::prepare_receive(UringClient &client)
+{
+    // Received bytes land straight in the free space of the reading ring.
+    memset(&client.receive_header, 0, sizeof(client.receive_header));
+    client.receive_header.msg_iov = client.receive_segments;
+    client.receive_header.msg_iovlen = client.socket->input_segments(client.receive_segments);
+    if (client.receive_header.msg_iovlen == 0)
+        return;
+
+    io_uring_sqe *sqe = next_submission();
+    sqe->opcode = IORING_OP_RECVMSG;
+    sqe->fd = client.socket->socket_fd;
+    sqe->addr = reinterpret_cast<uint64_t>(&client.receive_header);
+    sqe->len = 1;
+    sqe->user_data = user_data(&client, UringOperation::Receive);
+    queue_submission();
+
+    client.receiving = true;
+}
+
+void UringBackend::prepare_send(UringClient &client)
+{
+    // The storage of the writing ring is pinned, the ring may grow while the send is in flight.
+    memset(&client.send_header, 0, sizeof(client.send_header));
+    client.send_header.msg_iov = client.send_segments;
+    client.send_header.msg_iovlen = client.socket->output_segments(client.send_segments, MAX_OUTPUT_SEGMENTS);
+    client.send_storage = client.socket->output_storage();
+
+    io_uring_sqe *sqe = next_submission();
+    sqe->opcode = IORING_OP_SENDMSG;
+    sqe->fd = client.socket->socket_fd;
+    sqe->addr = reinterpret_cast<uint64_t>(&client.send_header);
+    sqe->len = 1;
+    sqe->msg_flags = MSG_NOSIGNAL;
+    sqe->user_data = user_data(&client, UringOperation::Send);
+    queue_submission();
+
+    client.sending = true;
+}
+
+void UringBackend::prepare_cancel(UringClient &client, UringOperation operation)
+{
+    io_uring_sqe *sqe = next_submission();
+    sqe->opcode = IORING_OP_ASYNC_CANCEL;
+    sqe->fd = -1;
+    sqe->addr = user_data(&client, operation);
+    sqe->user_data = user_data(nullptr, UringOperation::Cancel);
+    queue_submission();
+}
+
+void UringBackend::handle_completion(const io_uring_cqe &cqe)
+{
+    UringOperation operation = static_cast<UringOperation>(cqe.user_data & OPERATION_MASK);
+    UringClient *client = reinterpret_cast<UringClient *>(cqe.user_data & ~OPERATION_MASK);
+
+    if (operation == UringOperation::Cancel)
+        return;
+
+    if (operation == UringOperation::Accept)
+    {
+        if (cqe.res >= 0)
+            events.push_back(IOEvent{IOEventType::Accept, listener->adopt_connection(cqe.res, accept_address), false});
+        else if (listener->handle_accept_error(-cqe.res))
+        {
+            accept_resume_time = get_monotonic_time_in_millis() + ACCEPT_BACKOFF_MS;
+            return;
+        }
+
+        prepare_accept();
+        return;
+    }
+
+    if (operation == UringOperation::Inbox)
+    {
+        events.push_back(IOEvent{IOEventType::Inbox, nullptr, false});
+        prepare_inbox();
+        return;
+    }
+
+    if (operation == UringOperation::Receive)
+        client->receiving = false;
+    else
+    {
+        client->sending = false;
+        client->send_storage.reset();
+    }
+
+    if (client->removed)
+    {
+        if (!client->receiving && !client->sending)
+            removed_clients.erase(client);
+        return;
+    }
+
+    bool hangup = false;
+    if (cqe.res >= 0 && operation == UringOperation::Receive)
+    {
+        client->socket->handle_received(cqe.res);
+        hangup = cqe.res == 0;
+    }
+    else if (cqe.res >= 0)
+        client->socket->handle_sent(cqe.res);
+    else if (cqe.res != -EAGAIN && cqe.res != -EINTR)
+    {
+        // A reset peer closes only its own socket, the shard disconnects it like one that has hung up.
+        client->socket->handle_error(-cqe.res);
+        hangup = true;
+    }
+
+    // The shard handles the received messages and flushes the socket, which queues the next operations.
+    events.push_back(IOEvent{IOEventType::Client, client->socket, hangup});
+}
\ No newline at end of file
@@ -0,0 +1,172 @@
+#ifndef URING_BACKEND_H
+#define URING_BACKEND_H
+
+#include <linux/io_uring.h>
+#include <unordered_map>
+#include <vector>
+
+#include "io-backend.h"
+
+#define URING_ENTRIES 256
+
+/**
+ * @brief Operation submitted to io_uring, stored in the low bits of the user data
+ */
+enum class UringOperation : uint64_t
+{
+    Accept = 0,
+    Inbox = 1,
+    Receive = 2,
+    Send = 3,
+    Cancel = 4,
+};
+
+/**
+ * @brief Client connection with its I/O in flight
+ */
+struct UringClient
+{
+    std::shared_ptr<Socket> socket;
+    bool receiving;
+    bool sending;
+    bool removed;
+    bool throttled;
+    iovec receive_segments[2];
+    struct msghdr receive_header;
+    iovec send_segments[MAX_OUTPUT_SEGMENTS];
+    struct msghdr send_header;
+    std::shared_ptr<const char[]> send_storage;
+};
+
+/**
+ * @brief I/O backend based on io_uring completions
+ *
+ * Accepts, receives and sends are queued as submission entries and go to
+ * the kernel in one io_uring_enter per wakeup, which also waits for and
+ * reaps completions in bulk. Receives land straight in the free space of
+ * the sockets' reading rings and sends gather straight from their writing
+ * queues, so no intermediate buffers are needed. A receive is queued again
+ * only when the shard flushes the socket, so a socket whose messages have
+ * just been handled has no I/O in flight and can be handed off. No accept
+ * is queued for a while when descriptors run out.
+ */
+class UringBackend : public IOBackend
+{
+private:
+    int ring_fd;
+    unsigned sq_entries;
+    unsigned cq_entries;
+
+    void *rings;
+    size_t rings_size;
+    unsigned *sq_head;
+    unsigned *sq_tail;
+    unsigned *sq_mask;
+    unsigned *sq_array;
+    unsigned *cq_head;
+    unsigned *cq_tail;
+    unsigned *cq_mask;
+    io_uring_cqe *cqes;
+
+    io_uring_sqe *sqes;
+    size_t sqes_size;
+    unsigned pending_submissions;
+
+    Socket *listener;
+    long long accept_resume_time;
+    struct sockaddr_storage accept_address;
+    socklen_t accept_address_length;
+
+    int inbox_fd;
+
+    std::unordered_map<int, std::unique_ptr<UringClient>> clients;
+    std::unordered_map<UringClient *, std::unique_ptr<UringClient>> removed_clients;
+    std::vector<IOEvent> events;
+
+public:
+    /**
+     * @brief Construct a new UringBackend object
+     *
+     * @throws std::runtime_error if io_uring is not available or lacks needed features
+     */
+    UringBackend();
+
+    /**
+     * @brief Destroy the UringBackend object
+     */
+    ~UringBackend();
+
+    UringBackend(const UringBackend &) = delete;
+    UringBackend &operator=(const UringBackend &) = delete;
+
+    void add_listener(Socket &listener) override;
+    void add_inbox(int inbox_fd) override;
+    void add_client(const std::shared_ptr<Socket> &socket) override;
+    void remove_client(const std::shared_ptr<Socket> &socket) override;
+    void flush_client(const std::shared_ptr<Socket> &socket) override;
+    void throttle_client(const std::shared_ptr<Socket> &socket, bool throttled) override;
+    int wait(int timeout) override;
+    const IOEvent &event(int idx) const override;
+
+private:
+    /**
+     * @brief Get a free submission entry, submit queued ones first if there is none
+     *
+     * @return Cleared submission entry, queued by queue_submission
+     */
+    io_uring_sqe *next_submission();
+
+    /**
+     * @brief Queue the entry returned by next_submission
+     */
+    void queue_submission();
+
+    /**
+     * @brief Submit queued entries and optionally wait for completions
+     *
+     * @param wait_for_completion Whether to wait for at least one completion
+     * @param timeout Timeout in milliseconds, -1 means no timeout
+     */
+    void enter(bool wait_for_completion, int timeout);
+
+    /**
+     * @brief Queue accept on the listening socket
+     */
+    void prepare_accept();
+
+    /**
+     * @brief Queue poll of the inbox eventfd, the shard reads it itself
+     */
+    void prepare_inbox();
+
+    /**
+     * @brief Queue receive into the free space of the client's reading queue
+     *
+     * @param client Client
+     */
+    void prepare_receive(UringClient &client);
+
+    /**
+     * @brief Queue send of the client's writing queue
+     *
+     * @param client Client
+     */
+    void prepare_send(UringClient &client);
+
+    /**
+     * @brief Queue cancellation of an operation of a removed client
+     *
+     * @param client Client
+     * @param operation Operation to be cancelled
+     */
+    void prepare_cancel(UringClient &client, UringOperation operation);
+
+    /**
+     * @brief Handle completion
+     *
+     * @param cqe Completion entry
+     */
+    void handle_completion(const io_uring_cqe &cqe);
+};
+
+#endif // URING_BACKEND_H
\ No newline at end of file